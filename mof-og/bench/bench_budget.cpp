@@ -0,0 +1,493 @@
+// Benchmarks for the manager, file I/O and reporting hot paths.
+//
+//   bench_budget [--rows 10000,100000,1000000] [--only <name>] [--json <file>]
+//
+// Every benchmark runs against a synthetic ledger of each requested size and
+// reports throughput, per-operation latency percentiles and the peak resident
+// memory reached while it ran. --json writes the same results in a form that
+// can be diffed between releases.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+#include "../src/fileio.hpp"
+#include "../src/ingest_queue.hpp"
+#include "../src/kernels.hpp"
+#include "../src/manager.hpp"
+#include "../src/pager.hpp"
+#include "../src/query.hpp"
+
+using namespace budget;
+
+namespace {
+
+// Synthetic ledger
+
+// Builds ledgers that look like a household's: skewed category and currency
+// mixes, merchant-like descriptions that repeat, log-normal amounts and
+// timestamps spread over two years. Seeded, so every run sees the same data.
+class LedgerGenerator {
+private:
+    struct CategoryProfile {
+        Category category;
+        double weight;
+        double medianAmount;
+        std::vector<std::string_view> merchants;
+    };
+
+    std::mt19937_64 random_;
+    std::vector<CategoryProfile> profiles_;
+    std::discrete_distribution<std::size_t> pickCategory_;
+    std::discrete_distribution<std::size_t> pickCurrency_;
+    std::vector<Currency> currencies_;
+
+public:
+    explicit LedgerGenerator(std::uint64_t seed = 42) : random_(seed) {
+        profiles_ = {
+            {Category::FOOD, 25, 12.0, {"Pret", "Greggs", "Dishoom", "Nando's", "Wagamama", "Local cafe"}},
+            {Category::GROCERY, 20, 35.0, {"Tesco", "Sainsbury's", "Waitrose", "Lidl", "Aldi", "Ocado"}},
+            {Category::TRANSPORT, 15, 6.5, {"TfL", "Uber", "Trainline", "Shell", "Bolt"}},
+            {Category::HOUSING, 5, 450.0, {"Rent", "Council tax", "Thames Water", "Octopus Energy"}},
+            {Category::ENTERTAINMENT, 10, 18.0, {"Odeon", "Ticketmaster", "Steam", "Waterstones"}},
+            {Category::TOURISM, 3, 220.0, {"British Airways", "Booking.com", "Airbnb", "easyJet"}},
+            {Category::SUBSCRIPTIONS, 7, 9.99, {"Netflix", "Spotify", "iCloud", "Gym", "Guardian"}},
+            {Category::KITTENS, 5, 15.0, {"Pets at Home", "Vet", "Cat food", "Litter"}},
+            {Category::OTHER, 10, 20.0, {"Amazon", "Boots", "Post Office", "Gift"}},
+        };
+        std::vector<double> weights;
+        for (const auto& profile : profiles_) weights.push_back(profile.weight);
+        pickCategory_ = std::discrete_distribution<std::size_t>(weights.begin(), weights.end());
+
+        currencies_ = {Currency::GBP, Currency::USD, Currency::EUR, Currency::JPY, Currency::CHF};
+        pickCurrency_ = std::discrete_distribution<std::size_t>({80, 8, 8, 2, 2});
+    }
+
+    struct Row {
+        std::string description;
+        Money amount;
+        Category category;
+        Currency currency;
+        std::chrono::system_clock::time_point timestamp;
+    };
+
+    Row next() {
+        const CategoryProfile& profile = profiles_[pickCategory_(random_)];
+        Row row;
+        std::string_view merchant = profile.merchants[random_() % profile.merchants.size()];
+        row.description.assign(merchant);
+        // A third carry a reference number, so not every description repeats
+        if (random_() % 3 == 0) {
+            row.description += " #";
+            row.description += std::to_string(random_() % 100000);
+        }
+        std::lognormal_distribution<double> amount(std::log(profile.medianAmount), 0.6);
+        row.amount = Money::fromMajor(amount(random_));
+        row.category = profile.category;
+        row.currency = currencies_[pickCurrency_(random_)];
+        auto start = std::chrono::sys_days{std::chrono::year{2023} / 1 / 1};
+        row.timestamp = std::chrono::system_clock::time_point(start) + std::chrono::seconds(random_() % (730 * 86400));
+        return row;
+    }
+
+    void fill(BudgetManager& manager, std::size_t rows) {
+        manager.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i) {
+            Row row = next();
+            manager.restoreEntry(0, row.description, row.amount, row.category, row.currency, row.timestamp);
+        }
+    }
+
+    std::mt19937_64& random() { return random_; }
+};
+
+// Measurement
+
+// Peak resident set size of the process, in bytes; 0 where unsupported
+std::size_t peakRssBytes() {
+#ifdef __linux__
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmHWM:")) return std::stoull(line.substr(6)) * 1024;
+    }
+#endif
+#ifdef __unix__
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+// Lets the next peakRssBytes() report the peak of the next benchmark alone
+// (Linux only; elsewhere the peak covers the whole run so far)
+void resetPeakRss() {
+#ifdef __linux__
+    std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+}
+
+struct Result {
+    std::string name;
+    std::size_t rows = 0;
+    std::size_t operations = 0;
+    double seconds = 0.0;
+    std::size_t bytes = 0;        // data processed, for I/O benchmarks
+    double p50 = 0.0, p90 = 0.0, p99 = 0.0, max = 0.0; // nanoseconds per operation
+    std::size_t peakRss = 0;
+
+    double getOperationsPerSecond() const { return seconds > 0.0 ? static_cast<double>(operations) / seconds : 0.0; }
+    double getMegabytesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+// Times `operations` calls of `op(i)`, in batches of `batch` calls so that
+// operations shorter than the clock's resolution still get meaningful
+// percentiles (each batch contributes its mean as one sample)
+template <typename Op>
+Result measure(std::string name, std::size_t rows, std::size_t operations, std::size_t batch, Op op) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> samples;
+    samples.reserve(operations / batch + 1);
+
+    resetPeakRss();
+    auto begin = Clock::now();
+    for (std::size_t i = 0; i < operations;) {
+        std::size_t count = std::min(batch, operations - i);
+        auto start = Clock::now();
+        for (std::size_t end = i + count; i < end; ++i) op(i);
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+        samples.push_back(elapsed.count() / static_cast<double>(count));
+    }
+    std::chrono::duration<double> total = Clock::now() - begin;
+
+    Result result;
+    result.name = std::move(name);
+    result.rows = rows;
+    result.operations = operations;
+    result.seconds = total.count();
+    result.peakRss = peakRssBytes();
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<std::size_t>(p * static_cast<double>(samples.size())))];
+    };
+    if (!samples.empty()) {
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = samples.back();
+    }
+    return result;
+}
+
+std::string formatNanos(double nanos) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(nanos < 10.0 ? 2 : (nanos < 1000.0 ? 1 : 0));
+    if (nanos < 1e3) {
+        out << nanos << " ns";
+    } else if (nanos < 1e6) {
+        out << nanos / 1e3 << " us";
+    } else if (nanos < 1e9) {
+        out << nanos / 1e6 << " ms";
+    } else {
+        out << nanos / 1e9 << " s";
+    }
+    return out.str();
+}
+
+void printHeader() {
+    std::cout << std::left << std::setw(24) << "benchmark" << std::right << std::setw(10) << "rows"
+              << std::setw(14) << "ops/s" << std::setw(11) << "MB/s" << std::setw(11) << "p50"
+              << std::setw(11) << "p90" << std::setw(11) << "p99" << std::setw(11) << "max"
+              << std::setw(11) << "peak MB" << "\n"
+              << std::string(114, '-') << "\n";
+}
+
+void printResult(const Result& result) {
+    std::cout << std::left << std::setw(24) << result.name << std::right << std::setw(10) << result.rows
+              << std::setw(14) << std::fixed << std::setprecision(0) << result.getOperationsPerSecond()
+              << std::setw(11) << std::setprecision(1);
+    if (result.bytes > 0) {
+        std::cout << result.getMegabytesPerSecond();
+    } else {
+        std::cout << "-";
+    }
+    std::cout << std::setw(11) << formatNanos(result.p50) << std::setw(11) << formatNanos(result.p90)
+              << std::setw(11) << formatNanos(result.p99) << std::setw(11) << formatNanos(result.max)
+              << std::setw(11) << std::setprecision(1) << static_cast<double>(result.peakRss) / (1024.0 * 1024.0)
+              << "\n";
+}
+
+bool writeJson(const std::string& filename, const std::vector<Result>& results) {
+    std::ofstream out(filename);
+    out << std::setprecision(6) << "{\n  \"version\": 1,\n  \"isa\": \"" << HistogramKernel::getIsaName()
+        << "\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"rows\": " << r.rows << ", \"operations\": " << r.operations
+            << ", \"seconds\": " << r.seconds << ", \"ops_per_second\": " << r.getOperationsPerSecond()
+            << ", \"bytes\": " << r.bytes << ", \"mb_per_second\": " << r.getMegabytesPerSecond()
+            << ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90 << ", \"p99_ns\": " << r.p99
+            << ", \"max_ns\": " << r.max << ", \"peak_rss_bytes\": " << r.peakRss << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+// Benchmarks
+
+struct Options {
+    std::vector<std::size_t> rows = {10'000, 100'000, 1'000'000};
+    std::string only;
+    std::string json;
+};
+
+void runAll(std::size_t rows, const Options& options, std::vector<Result>& results) {
+    auto wanted = [&](std::string_view name) { return options.only.empty() || name.find(options.only) != std::string_view::npos; };
+    auto record = [&](Result result) {
+        printResult(result);
+        results.push_back(std::move(result));
+    };
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "mof_bench";
+    std::filesystem::create_directories(dir);
+
+    LedgerGenerator generator;
+    BudgetManager base;
+    generator.fill(base, rows);
+
+    // Pre-generated so the benchmark times the manager, not the generator
+    if (wanted("add_entry")) {
+        std::vector<LedgerGenerator::Row> pending;
+        pending.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i) pending.push_back(generator.next());
+        BudgetManager manager;
+        record(measure("add_entry", rows, rows, 256, [&](std::size_t i) {
+            const auto& row = pending[i];
+            manager.addEntry(row.description, row.amount, row.category, row.currency);
+        }));
+    }
+
+    // Four importers feeding one ledger; latencies are those of one producer's
+    // pushes, including any wait for room, and the total covers the final flush
+    if (wanted("ingest_queue")) {
+        constexpr std::size_t PRODUCERS = 4;
+        std::vector<NewEntry> pending;
+        pending.reserve(rows);
+        for (std::size_t i = 0; i < rows; ++i) {
+            auto row = generator.next();
+            pending.push_back(NewEntry{row.description, row.amount, row.category, row.currency, row.timestamp});
+        }
+        ConcurrentBudgetManager ledger;
+        IngestQueue queue(ledger);
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<std::thread> producers;
+        for (std::size_t p = 1; p < PRODUCERS; ++p) {
+            producers.emplace_back([&, p] {
+                for (std::size_t i = p; i < rows; i += PRODUCERS) queue.push(std::move(pending[i]));
+            });
+        }
+        Result result = measure("ingest_queue", rows, (rows + PRODUCERS - 1) / PRODUCERS, 256,
+                                [&](std::size_t i) { queue.push(std::move(pending[i * PRODUCERS])); });
+        for (auto& producer : producers) producer.join();
+        queue.flush();
+        result.operations = rows;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        result.peakRss = peakRssBytes();
+        record(result);
+    }
+
+    std::size_t touched = std::max<std::size_t>(rows / 10, 1);
+    if (wanted("modify_entry")) {
+        BudgetManager manager = base;
+        std::vector<std::string> ids;
+        for (std::size_t i = 0; i < touched; ++i) ids.push_back(std::to_string(1 + generator.random()() % rows));
+        record(measure("modify_entry", rows, touched, 64, [&](std::size_t i) {
+            manager.modifyEntry(ids[i], "Modified entry", Money::fromMinor(1234), Category::OTHER, Currency::GBP);
+        }));
+    }
+
+    if (wanted("delete_entry")) {
+        BudgetManager manager = base;
+        std::vector<std::string> ids;
+        for (std::size_t id = 1; id <= rows; ++id) ids.push_back(std::to_string(id));
+        std::shuffle(ids.begin(), ids.end(), generator.random());
+        ids.resize(touched);
+        record(measure("delete_entry", rows, touched, 64, [&](std::size_t i) { manager.deleteEntry(ids[i]); }));
+    }
+
+    if (wanted("total_by_category")) {
+        Money sink;
+        record(measure("total_by_category", rows, 1'000'000, 1024, [&](std::size_t i) {
+            sink += base.getTotalByCategory(static_cast<Category>(i % CATEGORY_COUNT),
+                                            static_cast<Currency>(i % CURRENCY_COUNT));
+        }));
+        if (sink == Money::fromMinor(-1)) std::cout << "";
+    }
+
+    if (wanted("entries_by_category")) {
+        std::size_t found = 0;
+        record(measure("entries_by_category", rows, 2 * CATEGORY_COUNT, 1, [&](std::size_t i) {
+            found += base.getEntriesByCategory(static_cast<Category>(i % CATEGORY_COUNT)).size();
+        }));
+    }
+
+    if (wanted("category_summary")) {
+        record(measure("category_summary", rows, 20, 1, [&](std::size_t) {
+            CategoryTotals totals = CategoryTotals::compute(base.getEntries());
+            auto converted = totals.getTotalsIn(base.getRates(), Currency::GBP);
+            if (converted[0] == Money::fromMinor(-1)) std::cout << "";
+        }));
+    }
+
+    if (wanted("monthly_totals")) {
+        BudgetManager manager = base; // the first call builds the time index
+        record(measure("monthly_totals", rows, 20, 1, [&](std::size_t) {
+            if (manager.getMonthlyTotals().empty()) std::cout << "";
+        }));
+    }
+
+    // "Biggest 20 spends this month": a scan of every row, then a walk of the amount order
+    for (bool sorted : {false, true}) {
+        std::string name = sorted ? "top_month_sorted" : "top_month_scan";
+        if (!wanted(name) || base.getEntryCount() == 0) continue;
+        BudgetManager manager = base;
+        if (sorted) {
+            manager.enableSortedViews();
+            manager.buildSortedViews(); // sorted once, outside the timing
+        }
+        std::chrono::year_month_day newest{
+            std::chrono::floor<std::chrono::days>(std::ranges::max(manager.getEntries().timestamps()))};
+        auto month = newest.year() / newest.month();
+        record(measure(name, rows, 20, 1, [&](std::size_t) {
+            if (Query(manager).onDates(month / 1, month / std::chrono::last).top(20).empty()) std::cout << "";
+        }));
+    }
+
+    if (wanted("render_page")) {
+        EntryPager pager(base, PagerOptions{50, 120, true});
+        std::size_t bytes = 0;
+        Result result = measure("render_page", rows, std::max<std::size_t>(rows / 50, 1), 16, [&](std::size_t) {
+            bytes += pager.page().size();
+            if (!pager.next()) pager.first();
+        });
+        result.bytes = bytes;
+        record(result);
+    }
+
+    std::string csv = (dir / "bench.csv").string();
+    std::string snapshot = (dir / "bench.mofsnap").string();
+    if (wanted("save_csv") || wanted("load_csv") || wanted("summarize_csv")) {
+        Result result = measure("save_csv", rows, 3, 1, [&](std::size_t) { FileIO::saveBudget(base, csv); });
+        result.bytes = 3 * std::filesystem::file_size(csv);
+        if (wanted("save_csv")) record(result);
+    }
+    for (unsigned threads : {1u, 0u}) {
+        std::string name = threads == 1 ? "load_csv" : "load_csv_parallel";
+        if (!wanted(name)) continue;
+        Result result = measure(name, rows, 3, 1, [&](std::size_t) {
+            BudgetManager manager;
+            FileIO::loadBudget(manager, csv, LoadOptions{.threads = threads});
+        });
+        result.bytes = 3 * std::filesystem::file_size(csv);
+        record(result);
+    }
+    if (wanted("summarize_csv")) {
+        std::vector<std::string> files = {csv};
+        Result result = measure("summarize_csv", rows, 3, 1, [&](std::size_t) {
+            BudgetSummary summary;
+            FileIO::summarize(files, summary);
+        });
+        result.bytes = 3 * std::filesystem::file_size(csv);
+        record(result);
+    }
+    if (wanted("save_snapshot") || wanted("load_snapshot")) {
+        Result result = measure("save_snapshot", rows, 3, 1, [&](std::size_t) { FileIO::saveSnapshot(base, snapshot); });
+        result.bytes = 3 * std::filesystem::file_size(snapshot);
+        if (wanted("save_snapshot")) record(result);
+    }
+    if (wanted("load_snapshot")) {
+        Result result = measure("load_snapshot", rows, 3, 1, [&](std::size_t) {
+            BudgetManager manager;
+            FileIO::loadSnapshot(manager, snapshot);
+        });
+        result.bytes = 3 * std::filesystem::file_size(snapshot);
+        record(result);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+bool parseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (i + 1 >= argc) return false;
+        if (arg == "--rows") {
+            options.rows.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                char* end = nullptr;
+                unsigned long long value = std::strtoull(item.c_str(), &end, 10);
+                if (value == 0 || *end != '\0') return false;
+                options.rows.push_back(static_cast<std::size_t>(value));
+            }
+        } else if (arg == "--only") {
+            options.only = argv[++i];
+        } else if (arg == "--json") {
+            options.json = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return !options.rows.empty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--rows 10000,100000,1000000] [--only <name>] [--json <file>]\n";
+        return 2;
+    }
+#ifndef NDEBUG
+    std::cerr << "warning: assertions are enabled; numbers will not be representative\n";
+#endif
+
+    std::cout << "Histogram kernel: " << HistogramKernel::getIsaName() << "\n\n";
+    printHeader();
+    std::vector<Result> results;
+    for (std::size_t rows : options.rows) {
+        runAll(rows, options, results);
+    }
+
+    if (!options.json.empty() && !writeJson(options.json, results)) {
+        std::cerr << "Failed to write " << options.json << "\n";
+        return 1;
+    }
+    return 0;
+}
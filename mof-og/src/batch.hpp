@@ -0,0 +1,355 @@
+#pragma once
+
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "fileio.hpp"
+#include "manager.hpp"
+#include "money.hpp"
+
+namespace budget {
+
+// Runs budget commands without prompts, for scripts and cron jobs. Each command
+// is one line of whitespace-separated words (double quotes group words, "" is a
+// literal quote, # starts a comment):
+//
+//   add <amount> <category> <currency> [description...]
+//   modify <id> <amount> <category> <currency> [description...]
+//   delete <id>
+//   load <file>              CSV or snapshot
+//   save <file>              snapshot if it ends in .mofsnap, CSV otherwise
+//   income <babu> <mamu>     monthly, in the base currency
+//   rate <currency> <units per base>
+//   summary [<currency>] [<YYYY-MM>]
+//   monthly [<currency>]
+//   count
+//   clear
+//
+// Every command writes one JSON object on its own line with its outcome and
+// how long it took; a final line gives the totals for the run.
+class BatchRunner {
+private:
+    BudgetManager& manager_;
+    std::ostream& out_;
+    std::size_t commands_ = 0;
+    std::size_t failed_ = 0;
+    std::chrono::steady_clock::duration elapsed_{};
+
+    struct Failure {
+        std::string message;
+    };
+
+    static void writeString(std::ostream& out, std::string_view text) {
+        static constexpr char HEX[] = "0123456789abcdef";
+        out << '"';
+        for (char c : text) {
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\r': out << "\\r"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out << "\\u00" << HEX[(c >> 4) & 0xF] << HEX[c & 0xF];
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+        out << '"';
+    }
+
+    static void writeMoney(std::ostream& out, Money amount) {
+        char text[Money::MAX_CHARS];
+        out.write(text, amount.toChars(text, text + sizeof(text)) - text);
+    }
+
+    static Money parseAmount(std::string_view text) {
+        auto amount = Money::parse(text);
+        if (!amount) throw Failure{"invalid amount: " + std::string(text)};
+        return *amount;
+    }
+
+    static Category parseCategory(std::string_view text) {
+        auto category = CategoryManager::tryFromString(text);
+        if (!category) throw Failure{"unknown category: " + std::string(text)};
+        return *category;
+    }
+
+    static Currency parseCurrency(std::string_view text) {
+        auto currency = CurrencyConverter::tryFromString(text);
+        if (!currency) throw Failure{"unknown currency: " + std::string(text)};
+        return *currency;
+    }
+
+    static double parseRate(std::string_view text) {
+        double rate = 0.0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), rate);
+        if (ec != std::errc{} || ptr != text.data() + text.size()) {
+            throw Failure{"invalid rate: " + std::string(text)};
+        }
+        return rate;
+    }
+
+    static void expectArguments(std::span<const std::string> args, std::size_t min, std::size_t max,
+                                std::string_view usage) {
+        if (args.size() < min || args.size() > max) throw Failure{"usage: " + std::string(usage)};
+    }
+
+    static std::string joinWords(std::span<const std::string> words) {
+        std::string text;
+        for (const auto& word : words) {
+            if (!text.empty()) text += ' ';
+            text += word;
+        }
+        return text;
+    }
+
+    void writeTotals(std::ostream& out, const CategoryTotals& totals, Currency currency) {
+        auto converted = totals.getTotalsIn(manager_.getRates(), currency);
+        Money spent;
+        out << ",\"categories\":{";
+        bool first = true;
+        for (auto category : CategoryManager::getAllCategories()) {
+            Money total = converted[static_cast<std::size_t>(category)];
+            if (total == Money{}) continue;
+            out << (first ? "" : ",");
+            writeString(out, CategoryManager::toString(category));
+            out << ':';
+            writeMoney(out, total);
+            spent += total;
+            first = false;
+        }
+        out << "},\"spent\":";
+        writeMoney(out, spent);
+        out << ",\"income\":";
+        writeMoney(out, manager_.getRates().convert(manager_.getIncome(), BASE_CURRENCY, currency));
+    }
+
+    // Runs one command, writing its result fields to `out`
+    void execute(std::ostream& out, std::string_view command, std::span<const std::string> args) {
+        if (command == "add") {
+            expectArguments(args, 3, SIZE_MAX, "add <amount> <category> <currency> [description...]");
+            std::string id = manager_.addEntry(joinWords(args.subspan(3)), parseAmount(args[0]),
+                                               parseCategory(args[1]), parseCurrency(args[2]));
+            out << ",\"id\":" << id;
+        } else if (command == "modify") {
+            expectArguments(args, 4, SIZE_MAX, "modify <id> <amount> <category> <currency> [description...]");
+            if (!manager_.modifyEntry(args[0], joinWords(args.subspan(4)), parseAmount(args[1]),
+                                      parseCategory(args[2]), parseCurrency(args[3]))) {
+                throw Failure{"no entry with ID " + args[0]};
+            }
+        } else if (command == "delete") {
+            expectArguments(args, 1, 1, "delete <id>");
+            if (!manager_.deleteEntry(args[0])) throw Failure{"no entry with ID " + args[0]};
+        } else if (command == "load") {
+            expectArguments(args, 1, 1, "load <file>");
+            if (!FileIO::loadAny(manager_, args[0], LoadOptions{.threads = 0})) {
+                throw Failure{"failed to load " + args[0]};
+            }
+            out << ",\"entries\":" << manager_.getEntryCount();
+        } else if (command == "save") {
+            expectArguments(args, 1, 1, "save <file>");
+            bool saved = args[0].ends_with(".mofsnap") ? FileIO::saveSnapshot(manager_, args[0])
+                                                       : FileIO::saveBudget(manager_, args[0]);
+            if (!saved) throw Failure{"failed to save " + args[0]};
+            out << ",\"entries\":" << manager_.getEntryCount();
+        } else if (command == "income") {
+            expectArguments(args, 2, 2, "income <babu> <mamu>");
+            Money babu = parseAmount(args[0]);
+            Money mamu = parseAmount(args[1]);
+            manager_.setBabuIncome(babu);
+            manager_.setMamuIncome(mamu);
+        } else if (command == "rate") {
+            expectArguments(args, 2, 2, "rate <currency> <units per base>");
+            manager_.setRate(parseCurrency(args[0]), parseRate(args[1]));
+        } else if (command == "summary") {
+            expectArguments(args, 0, 2, "summary [<currency>] [<YYYY-MM>]");
+            Currency currency = BASE_CURRENCY;
+            std::optional<std::chrono::year_month> month;
+            for (const auto& arg : args) {
+                if (auto parsed = parseMonth(arg)) {
+                    month = parsed;
+                } else {
+                    currency = parseCurrency(arg);
+                }
+            }
+            out << ",\"currency\":";
+            writeString(out, CurrencyConverter::toString(currency));
+            if (month) {
+                out << ",\"month\":";
+                writeString(out, formatMonth(*month));
+                writeTotals(out, manager_.getTotalsForMonth(*month), currency);
+            } else {
+                writeTotals(out, manager_.getCategoryTotals(), currency);
+            }
+        } else if (command == "monthly") {
+            expectArguments(args, 0, 1, "monthly [<currency>]");
+            Currency currency = args.empty() ? BASE_CURRENCY : parseCurrency(args[0]);
+            out << ",\"currency\":";
+            writeString(out, CurrencyConverter::toString(currency));
+            out << ",\"months\":{";
+            bool first = true;
+            for (const auto& [month, totals] : manager_.getMonthlyTotals()) {
+                Money spent;
+                for (Money total : totals.getTotalsIn(manager_.getRates(), currency)) spent += total;
+                out << (first ? "" : ",");
+                writeString(out, formatMonth(month));
+                out << ':';
+                writeMoney(out, spent);
+                first = false;
+            }
+            out << '}';
+        } else if (command == "count") {
+            expectArguments(args, 0, 0, "count");
+            out << ",\"entries\":" << manager_.getEntryCount();
+        } else if (command == "clear") {
+            expectArguments(args, 0, 0, "clear");
+            manager_.clear();
+        } else {
+            throw Failure{"unknown command"};
+        }
+    }
+
+public:
+    BatchRunner(BudgetManager& manager, std::ostream& out) : manager_(manager), out_(out) {}
+
+    // Runs one command given as words, e.g. from argv; returns true on success
+    bool run(std::span<const std::string> words, std::size_t line = 0) {
+        if (words.empty()) return true;
+        auto start = std::chrono::steady_clock::now();
+        ++commands_;
+
+        // Kept apart until it is known whether the command succeeded
+        std::ostringstream fields;
+        std::optional<std::string> error;
+        try {
+            execute(fields, words[0], words.subspan(1));
+        } catch (const Failure& failure) {
+            error = failure.message;
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        auto took = std::chrono::steady_clock::now() - start;
+        elapsed_ += took;
+        std::chrono::duration<double, std::milli> elapsed = took;
+
+        out_ << '{';
+        if (line > 0) out_ << "\"line\":" << line << ',';
+        out_ << "\"command\":";
+        writeString(out_, words[0]);
+        if (error) {
+            ++failed_;
+            out_ << ",\"ok\":false,\"error\":";
+            writeString(out_, *error);
+        } else {
+            out_ << ",\"ok\":true" << fields.str();
+        }
+        out_ << ",\"ms\":" << elapsed.count() << "}\n";
+        return !error;
+    }
+
+    // Runs every command read from `in`; returns the number that failed
+    std::size_t run(std::istream& in) {
+        std::string text;
+        std::size_t line = 0;
+        while (std::getline(in, text)) {
+            ++line;
+            auto words = splitWords(text);
+            if (!words) {
+                ++commands_;
+                ++failed_;
+                out_ << "{\"line\":" << line << ",\"ok\":false,\"error\":\"unterminated quote\",\"ms\":0}\n";
+                continue;
+            }
+            run(*words, line);
+        }
+        return failed_;
+    }
+
+    // The closing line: how many commands ran, how many failed, and the time spent in them
+    void finish() {
+        std::chrono::duration<double, std::milli> elapsed = elapsed_;
+        out_ << "{\"done\":true,\"commands\":" << commands_ << ",\"failed\":" << failed_
+             << ",\"entries\":" << manager_.getEntryCount() << ",\"ms\":" << elapsed.count() << "}\n";
+        out_.flush();
+    }
+
+    static bool isCommand(std::string_view word) {
+        for (std::string_view command : {"add", "modify", "delete", "load", "save", "income", "rate", "summary",
+                                         "monthly", "count", "clear"}) {
+            if (word == command) return true;
+        }
+        return false;
+    }
+
+    std::size_t getCommandCount() const { return commands_; }
+    std::size_t getFailedCount() const { return failed_; }
+
+    // Splits a command line into words; nullopt if a quote is left open
+    static std::optional<std::vector<std::string>> splitWords(std::string_view text) {
+        std::vector<std::string> words;
+        std::size_t i = 0;
+        while (i < text.size()) {
+            while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\r')) ++i;
+            if (i == text.size() || text[i] == '#') break;
+
+            std::string word;
+            while (i < text.size() && text[i] != ' ' && text[i] != '\t' && text[i] != '\r') {
+                if (text[i] != '"') {
+                    word += text[i++];
+                    continue;
+                }
+                for (++i;; ++i) {
+                    if (i == text.size()) return std::nullopt;
+                    if (text[i] == '"') {
+                        if (i + 1 < text.size() && text[i + 1] == '"') {
+                            word += '"';
+                            ++i;
+                            continue;
+                        }
+                        ++i;
+                        break;
+                    }
+                    word += text[i];
+                }
+            }
+            words.push_back(std::move(word));
+        }
+        return words;
+    }
+
+    // Parses "YYYY-MM"
+    static std::optional<std::chrono::year_month> parseMonth(std::string_view text) {
+        int year = 0;
+        unsigned month = 0;
+        if (text.size() != 7 || text[4] != '-' ||
+            std::from_chars(text.data(), text.data() + 4, year).ptr != text.data() + 4 ||
+            std::from_chars(text.data() + 5, text.data() + 7, month).ptr != text.data() + 7) {
+            return std::nullopt;
+        }
+        std::chrono::year_month result{std::chrono::year{year}, std::chrono::month{month}};
+        return result.ok() ? std::optional{result} : std::nullopt;
+    }
+
+    static std::string formatMonth(std::chrono::year_month month) {
+        unsigned m = static_cast<unsigned>(month.month());
+        return std::to_string(static_cast<int>(month.year())) + (m < 10 ? "-0" : "-") + std::to_string(m);
+    }
+};
+
+} // namespace budget
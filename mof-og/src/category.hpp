@@ -1,67 +1,71 @@
 #pragma once
 
-#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string_view>
-#include <vector>
 #include <stdexcept>
 
+#include "enum_table.hpp"
+
 namespace budget {
 
-enum class Category {
-    FOOD,
-    GROCERY,
-    TRANSPORT,
-    HOUSING,
-    ENTERTAINMENT,
-    TOURISM,
-    SUBSCRIPTIONS,
-    KITTENS,
-    OTHER
+// X(enumerator, display name). New categories go at the end: files and
+// snapshots store the enum value, and the name is what CSV files hold.
+#define BUDGET_CATEGORIES(X)              \
+    X(FOOD, "Food")                       \
+    X(GROCERY, "Grocery")                 \
+    X(TRANSPORT, "Transport")             \
+    X(HOUSING, "Housing")                 \
+    X(ENTERTAINMENT, "Entertainment")     \
+    X(TOURISM, "Tourism")                 \
+    X(SUBSCRIPTIONS, "Subscriptions")     \
+    X(KITTENS, "Kittens")                 \
+    X(OTHER, "Other")
+
+enum class Category : std::uint8_t {
+#define BUDGET_CATEGORY_ENUMERATOR(id, name) id,
+    BUDGET_CATEGORIES(BUDGET_CATEGORY_ENUMERATOR)
+#undef BUDGET_CATEGORY_ENUMERATOR
 };
 
+inline constexpr auto ALL_CATEGORIES = std::to_array<Category>({
+#define BUDGET_CATEGORY_VALUE(id, name) Category::id,
+    BUDGET_CATEGORIES(BUDGET_CATEGORY_VALUE)
+#undef BUDGET_CATEGORY_VALUE
+});
+
+inline constexpr std::size_t CATEGORY_COUNT = ALL_CATEGORIES.size();
+
+inline constexpr EnumNameTable<Category, CATEGORY_COUNT> CATEGORY_NAMES{std::to_array<std::string_view>({
+#define BUDGET_CATEGORY_NAME(id, name) name,
+    BUDGET_CATEGORIES(BUDGET_CATEGORY_NAME)
+#undef BUDGET_CATEGORY_NAME
+})};
+
 class CategoryManager {
 public:
-    static std::string toString(Category category) {
-        switch (category) {
-            case Category::FOOD: return "Food";
-            case Category::GROCERY: return "Grocery";
-            case Category::TRANSPORT: return "Transport";
-            case Category::HOUSING: return "Housing";
-            case Category::ENTERTAINMENT: return "Entertainment";
-            case Category::TOURISM: return "Tourism";
-            case Category::SUBSCRIPTIONS: return "Subscriptions";
-            case Category::KITTENS: return "Kittens";
-            case Category::OTHER: return "Other";
-        }
-        throw std::invalid_argument("Invalid category");
+    static constexpr std::string_view toString(Category category) {
+        return CATEGORY_NAMES.name(category);
+    }
+
+    // Case-insensitive
+    static constexpr std::optional<Category> tryFromString(std::string_view str) noexcept {
+        return CATEGORY_NAMES.find(str);
     }
 
     static Category fromString(std::string_view str) {
-        if (str == "Food" || str == "food") return Category::FOOD;
-        if (str == "Grocery" || str == "grocery") return Category::GROCERY;
-        if (str == "Transport" || str == "transport") return Category::TRANSPORT;
-        if (str == "Housing" || str == "housing") return Category::HOUSING;
-        if (str == "Entertainment" || str == "entertainment") return Category::ENTERTAINMENT;
-        if (str == "Tourism" || str == "tourism") return Category::TOURISM;
-        if (str == "Subscriptions" || str == "subscriptions") return Category::SUBSCRIPTIONS;
-        if (str == "Kittens" || str == "kittens") return Category::KITTENS;
-        if (str == "Other" || str == "other") return Category::OTHER;
+        if (auto category = tryFromString(str)) return *category;
         throw std::invalid_argument("Invalid category string");
     }
 
-    static std::vector<Category> getAllCategories() {
-        return {
-            Category::FOOD,
-            Category::GROCERY,
-            Category::TRANSPORT,
-            Category::HOUSING,
-            Category::ENTERTAINMENT,
-            Category::TOURISM,
-            Category::SUBSCRIPTIONS,
-            Category::KITTENS,
-            Category::OTHER
-        };
+    static constexpr const std::array<Category, CATEGORY_COUNT>& getAllCategories() {
+        return ALL_CATEGORIES;
     }
 };
 
+static_assert(CategoryManager::tryFromString("kittens") == Category::KITTENS);
+static_assert(CategoryManager::toString(Category::OTHER) == "Other");
+
 } // namespace budget
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "manager.hpp"
+
+namespace budget {
+
+// A BudgetManager shared between writer and reader threads.
+//
+// Writers take turns (one mutex) applying mutations to a private working copy
+// and then publish an immutable copy of it. Readers take a Snapshot of the
+// latest published copy without locking: they announce the epoch they start in,
+// then read the current pointer. A published copy that has been replaced is
+// freed only once every reader that might still hold it has left, so readers
+// never wait on writers and writers never wait on readers.
+//
+// Publishing does not copy the ledger each time. The working copy's mutations
+// are logged through its BudgetListener, and a publish brings a copy no reader
+// holds any more up to date by replaying the changes it missed, so a
+// single-entry write costs O(1) amortised rather than O(ledger). A full copy
+// is made only when no freed copy is at hand (snapshots are holding them all)
+// or when more changed than replaying is worth, e.g. one large update().
+// Snapshots should still be short-lived: each one keeps every copy published
+// since it was taken alive.
+class ConcurrentBudgetManager {
+private:
+    static constexpr std::size_t MAX_READERS = 64; // Snapshots alive at once
+    static constexpr std::uint64_t IDLE = 0;       // epoch of an unused reader slot
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<std::uint64_t> epoch{IDLE};
+    };
+
+    struct Retired {
+        const BudgetManager* manager;
+        std::uint64_t epoch;   // readers that started in a later epoch cannot see it
+        std::uint64_t version; // publish count when it was published
+    };
+
+    enum class ChangeType : std::uint8_t {
+        ADD,
+        MODIFY,
+        REMOVE,
+        CLEAR,
+        SETTING,
+        RATE
+    };
+
+    // One mutation of the working copy, tagged with the publish count at the
+    // time; a copy published as version v has seen every change tagged below v
+    struct Change {
+        std::uint64_t version;
+        ChangeType type;
+        EntryId id = 0;
+        std::string description{};
+        Money amount{};
+        Category category{};
+        Currency currency{};
+        std::chrono::system_clock::time_point timestamp{};
+        BudgetSetting setting{};
+        double value = 0.0;
+    };
+
+    // Logs the working copy's mutations for replay, and passes them on to the
+    // listener installed with setListener
+    class ChangeLog : public BudgetListener {
+    private:
+        ConcurrentBudgetManager& owner_;
+
+        void record(Change change) {
+            if (owner_.logBase_ > owner_.publishes_) return; // overflowed; the next publish copies
+            // Replaying beyond this costs more than copying, and holds as much memory
+            std::size_t limit = std::max(MIN_LOG_LIMIT, owner_.working_.getEntryCount() / 8);
+            if (owner_.log_.size() >= limit) {
+                owner_.log_.clear();
+                owner_.logBase_ = owner_.publishes_ + 1;
+                return;
+            }
+            change.version = owner_.publishes_;
+            owner_.log_.push_back(std::move(change));
+        }
+
+        void recordEntry(ChangeType type, const EntryView& entry) {
+            record(Change{.version = 0, .type = type, .id = entry.getId(),
+                          .description = std::string(entry.getDescription()), .amount = entry.getAmount(),
+                          .category = entry.getCategory(), .currency = entry.getCurrency(),
+                          .timestamp = entry.getTimestamp()});
+        }
+
+    public:
+        BudgetListener* forward = nullptr;
+
+        explicit ChangeLog(ConcurrentBudgetManager& owner) : owner_(owner) {}
+
+        void onAdd(const EntryView& entry) override {
+            recordEntry(ChangeType::ADD, entry);
+            if (forward) forward->onAdd(entry);
+        }
+
+        void onModify(const EntryView& entry) override {
+            recordEntry(ChangeType::MODIFY, entry);
+            if (forward) forward->onModify(entry);
+        }
+
+        void onDelete(EntryId id) override {
+            record(Change{.version = 0, .type = ChangeType::REMOVE, .id = id});
+            if (forward) forward->onDelete(id);
+        }
+
+        void onClear() override {
+            record(Change{.version = 0, .type = ChangeType::CLEAR});
+            if (forward) forward->onClear();
+        }
+
+        void onSetting(BudgetSetting setting, double value) override {
+            // Incomes are taken from the working copy, exact, rather than from the double
+            Money amount = setting == BudgetSetting::BABU_INCOME   ? owner_.working_.getBabuIncome()
+                           : setting == BudgetSetting::MAMU_INCOME ? owner_.working_.getMamuIncome()
+                                                                   : Money{};
+            record(Change{.version = 0, .type = ChangeType::SETTING, .amount = amount, .setting = setting,
+                          .value = value});
+            if (forward) forward->onSetting(setting, value);
+        }
+
+        void onRate(Currency currency, double unitsPerBase) override {
+            record(Change{.version = 0, .type = ChangeType::RATE, .currency = currency, .value = unitsPerBase});
+            if (forward) forward->onRate(currency, unitsPerBase);
+        }
+    };
+
+    static constexpr std::size_t MIN_LOG_LIMIT = 4096; // changes kept for replay, at least
+
+    mutable std::array<ReaderSlot, MAX_READERS> readers_;
+    std::atomic<std::uint64_t> epoch_{1};
+    std::atomic<const BudgetManager*> current_{nullptr};
+
+    mutable std::mutex writeMutex_;
+    BudgetManager working_;
+    std::vector<Retired> retired_;
+    std::unique_ptr<BudgetManager> spare_; // a freed copy, brought up to date for the next publish
+    std::uint64_t spareVersion_ = 0;
+    std::uint64_t publishes_ = 0;
+    std::uint64_t copies_ = 0;
+
+    ChangeLog changeLog_{*this};
+    std::vector<Change> log_; // every change tagged logBase_ or later, oldest first
+    std::uint64_t logBase_ = 0;
+
+    // Applies the changes a copy published as `version` has not seen
+    void replay(BudgetManager& manager, std::uint64_t version) const {
+        auto first = std::ranges::lower_bound(log_, version, {}, &Change::version);
+        for (const Change& change : std::ranges::subrange(first, log_.end())) {
+            switch (change.type) {
+                case ChangeType::ADD:
+                    manager.restoreEntry(change.id, change.description, change.amount, change.category,
+                                         change.currency, change.timestamp);
+                    break;
+                case ChangeType::MODIFY:
+                    manager.modifyEntry(std::to_string(change.id), change.description, change.amount,
+                                        change.category, change.currency);
+                    break;
+                case ChangeType::REMOVE:
+                    manager.deleteEntry(std::to_string(change.id));
+                    break;
+                case ChangeType::CLEAR:
+                    manager.clear();
+                    break;
+                case ChangeType::SETTING:
+                    if (change.setting == BudgetSetting::BABU_INCOME) {
+                        manager.setBabuIncome(change.amount);
+                    } else if (change.setting == BudgetSetting::MAMU_INCOME) {
+                        manager.setMamuIncome(change.amount);
+                    } else if (change.setting == BudgetSetting::NEXT_ID) {
+                        manager.reserveIdsBelow(static_cast<EntryId>(change.value));
+                    } else {
+                        manager.setExchangeRate(change.value);
+                    }
+                    break;
+                case ChangeType::RATE:
+                    manager.setRate(change.currency, change.value);
+                    break;
+            }
+        }
+    }
+
+    // writeMutex_ must be held
+    void publish() {
+        working_.buildTimeIndex();
+        working_.buildSortedViews();
+        std::unique_ptr<BudgetManager> next = std::move(spare_);
+        if (next && spareVersion_ >= logBase_) {
+            replay(*next, spareVersion_);
+            if (working_.getSortedView(SortKey::AMOUNT)) next->enableSortedViews();
+        } else {
+            if (next) {
+                *next = working_;
+            } else {
+                next = std::make_unique<BudgetManager>(working_);
+            }
+            next->setListener(nullptr);
+            ++copies_;
+        }
+        // Readers share the copy, so nothing may be left to build on first use
+        next->buildTimeIndex();
+        next->buildSortedViews();
+
+        const BudgetManager* old = current_.exchange(next.release());
+        std::uint64_t epoch = epoch_.fetch_add(1);
+        if (old) retired_.push_back(Retired{old, epoch, publishes_});
+        ++publishes_;
+        reclaim();
+
+        // Keep only the changes some copy has yet to see
+        std::uint64_t oldest = publishes_;
+        if (spare_) oldest = std::min(oldest, spareVersion_);
+        for (const auto& retired : retired_) oldest = std::min(oldest, retired.version);
+        if (oldest > logBase_) {
+            std::erase_if(log_, [&](const Change& change) { return change.version < oldest; });
+            logBase_ = oldest;
+        }
+    }
+
+    // Frees the retired copies no reader can still hold; writeMutex_ must be held
+    void reclaim() {
+        std::uint64_t oldest = UINT64_MAX;
+        for (const auto& slot : readers_) {
+            std::uint64_t epoch = slot.epoch.load();
+            if (epoch != IDLE && epoch < oldest) oldest = epoch;
+        }
+        std::erase_if(retired_, [&](const Retired& retired) {
+            if (retired.epoch >= oldest) return false;
+            if (!spare_) {
+                spare_.reset(const_cast<BudgetManager*>(retired.manager));
+                spareVersion_ = retired.version;
+            } else {
+                delete retired.manager;
+            }
+            return true;
+        });
+    }
+
+public:
+    // A consistent, read-only view of the ledger as of one publish. Holding it
+    // keeps that copy alive; it must not outlive the ConcurrentBudgetManager.
+    class Snapshot {
+    private:
+        ReaderSlot* slot_ = nullptr;
+        const BudgetManager* manager_ = nullptr;
+
+        friend class ConcurrentBudgetManager;
+        Snapshot(ReaderSlot* slot, const BudgetManager* manager) : slot_(slot), manager_(manager) {}
+
+    public:
+        Snapshot(Snapshot&& other) noexcept
+            : slot_(std::exchange(other.slot_, nullptr)), manager_(std::exchange(other.manager_, nullptr)) {}
+
+        Snapshot& operator=(Snapshot&& other) noexcept {
+            if (this != &other) {
+                release();
+                slot_ = std::exchange(other.slot_, nullptr);
+                manager_ = std::exchange(other.manager_, nullptr);
+            }
+            return *this;
+        }
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        ~Snapshot() { release(); }
+
+        void release() {
+            if (slot_) slot_->epoch.store(IDLE, std::memory_order_release);
+            slot_ = nullptr;
+            manager_ = nullptr;
+        }
+
+        const BudgetManager& operator*() const { return *manager_; }
+        const BudgetManager* operator->() const { return manager_; }
+    };
+
+    explicit ConcurrentBudgetManager(BudgetManager initial = {}) : working_(std::move(initial)) {
+        std::lock_guard lock(writeMutex_);
+        working_.setListener(&changeLog_);
+        publish();
+    }
+
+    ConcurrentBudgetManager(const ConcurrentBudgetManager&) = delete;
+    ConcurrentBudgetManager& operator=(const ConcurrentBudgetManager&) = delete;
+
+    // Every Snapshot must have been released
+    ~ConcurrentBudgetManager() {
+        delete current_.load();
+        for (const auto& retired : retired_) delete retired.manager;
+    }
+
+    // Lock-free unless MAX_READERS snapshots are already alive, in which case
+    // it waits for one of them to be released
+    Snapshot snapshot() const {
+        std::size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        for (;;) {
+            for (std::size_t i = 0; i < MAX_READERS; ++i) {
+                ReaderSlot& slot = readers_[(start + i) % MAX_READERS];
+                std::uint64_t expected = IDLE;
+                // Announcing an epoch that is already stale only delays reclamation
+                if (slot.epoch.load(std::memory_order_relaxed) == IDLE &&
+                    slot.epoch.compare_exchange_strong(expected, epoch_.load())) {
+                    return Snapshot(&slot, current_.load());
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Applies `mutation` to the working copy and publishes the result, even if
+    // `mutation` throws part-way. Writers are serialised; readers are not blocked.
+    // `mutation` must not replace the manager's listener (use setListener).
+    template <std::invocable<BudgetManager&> Mutation>
+    std::invoke_result_t<Mutation, BudgetManager&> update(Mutation&& mutation) {
+        std::lock_guard lock(writeMutex_);
+        struct PublishOnExit {
+            ConcurrentBudgetManager& owner;
+            ~PublishOnExit() { owner.publish(); }
+        } publishOnExit{*this};
+        return std::invoke(std::forward<Mutation>(mutation), working_);
+    }
+
+    std::string addEntry(std::string description, Money amount, Category category, Currency currency) {
+        return update([&](BudgetManager& manager) {
+            return manager.addEntry(std::move(description), amount, category, currency);
+        });
+    }
+
+    bool modifyEntry(const std::string& id, std::string description, Money amount, Category category,
+                     Currency currency) {
+        return update([&](BudgetManager& manager) {
+            return manager.modifyEntry(id, std::move(description), amount, category, currency);
+        });
+    }
+
+    bool deleteEntry(const std::string& id) {
+        return update([&](BudgetManager& manager) { return manager.deleteEntry(id); });
+    }
+
+    // Appends the whole batch with one publish; returns the first ID assigned
+    EntryId addEntries(std::span<const NewEntry> batch) {
+        return update([&](BudgetManager& manager) { return manager.addEntries(batch); });
+    }
+
+    void setRate(Currency currency, double unitsPerBase) {
+        update([&](BudgetManager& manager) { manager.setRate(currency, unitsPerBase); });
+    }
+
+    // Told about mutations as they are applied to the working copy, under the writer lock
+    void setListener(BudgetListener* listener) {
+        std::lock_guard lock(writeMutex_);
+        changeLog_.forward = listener;
+    }
+
+    Money getTotalByCategory(Category category, Currency currency) const {
+        return snapshot()->getTotalByCategory(category, currency);
+    }
+
+    CategoryTotals getCategoryTotals() const {
+        return snapshot()->getCategoryTotals();
+    }
+
+    size_t getEntryCount() const {
+        return snapshot()->getEntryCount();
+    }
+
+    // Copies published so far, the initial one included
+    std::uint64_t getPublishCount() const {
+        std::lock_guard lock(writeMutex_);
+        return publishes_;
+    }
+
+    // Publishes that copied the whole ledger instead of replaying recent changes
+    std::uint64_t getFullCopyCount() const {
+        std::lock_guard lock(writeMutex_);
+        return copies_;
+    }
+};
+
+} // namespace budget
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "csv_scan.hpp"
+#include "parallel.hpp"
+
+namespace budget {
+
+// Splits CSV text into records and fields without copying.
+// Fields are views into the source text, except quoted fields containing
+// doubled quotes, which are unescaped into a scratch buffer owned by the reader.
+// Views stay valid until the next call to next(). Quoted fields may span lines.
+//
+// Separators are found with CsvScanner one 64-byte block at a time: commas and
+// newlines that fall outside quotes form a bitmask, and each field boundary is
+// the next set bit, so the reader never branches on individual bytes.
+class CsvReader {
+private:
+    std::string_view data_;
+    std::size_t pos_ = 0;              // start of the next record
+    std::size_t blockBase_ = 0;        // offset of the block described by separators_
+    std::uint64_t separators_ = 0;     // unconsumed separators in the current block
+    std::uint64_t inQuotesCarry_ = 0;  // all ones if the next block starts inside quotes
+    std::string_view record_;
+    std::vector<std::string_view> fields_;
+    std::string scratch_;
+
+    void loadBlock() {
+        CsvBlockMasks masks = CsvScanner::classify(data_.substr(blockBase_, CsvScanner::BLOCK_SIZE));
+        std::uint64_t inQuotes = CsvScanner::prefixXor(masks.quotes) ^ inQuotesCarry_;
+        inQuotesCarry_ = std::uint64_t{0} - (inQuotes >> 63);
+        separators_ = (masks.commas | masks.newlines) & ~inQuotes;
+    }
+
+    // Offset of the next comma or newline outside quotes, or data_.size()
+    std::size_t nextSeparator() {
+        while (separators_ == 0) {
+            blockBase_ += CsvScanner::BLOCK_SIZE;
+            if (blockBase_ >= data_.size()) {
+                return data_.size();
+            }
+            loadBlock();
+        }
+        std::size_t separator = blockBase_ + static_cast<std::size_t>(std::countr_zero(separators_));
+        separators_ &= separators_ - 1;
+        return std::min(separator, data_.size());
+    }
+
+    // Strips the quotes from a quoted field and collapses doubled quotes
+    std::string_view unquote(std::string_view field) {
+        if (field.empty() || field.front() != '"') {
+            return field;
+        }
+        std::size_t closing = field.rfind('"');
+        std::string_view content = closing > 0 ? field.substr(1, closing - 1) : field.substr(1);
+        if (content.find('"') == std::string_view::npos) {
+            return content;
+        }
+        std::size_t start = scratch_.size();
+        for (std::size_t i = 0; i < content.size(); ++i) {
+            scratch_ += content[i];
+            if (content[i] == '"' && i + 1 < content.size() && content[i + 1] == '"') ++i;
+        }
+        return std::string_view(scratch_).substr(start);
+    }
+
+public:
+    explicit CsvReader(std::string_view data) : data_(data) {
+        if (!data_.empty()) {
+            loadBlock();
+        }
+    }
+
+    // Advances to the next record; returns false once the input is exhausted
+    bool next() {
+        if (pos_ >= data_.size()) {
+            return false;
+        }
+
+        fields_.clear();
+        std::size_t start = pos_;
+        std::size_t end;
+        while (true) {
+            std::size_t separator = nextSeparator();
+            fields_.push_back(data_.substr(start, separator - start));
+            if (separator == data_.size() || data_[separator] == '\n') {
+                end = separator;
+                break;
+            }
+            start = separator + 1;
+        }
+
+        record_ = data_.substr(pos_, end - pos_);
+        if (!record_.empty() && record_.back() == '\r') {
+            record_.remove_suffix(1);
+            fields_.back().remove_suffix(1);
+        }
+        pos_ = end + 1;
+
+        // Unescaped text is never longer than the record, so views into scratch_ stay valid
+        scratch_.clear();
+        scratch_.reserve(record_.size());
+        for (auto& field : fields_) {
+            field = unquote(field);
+        }
+        return true;
+    }
+
+    // Raw text of the current record, without its line terminator
+    std::string_view record() const { return record_; }
+
+    std::span<const std::string_view> fields() const { return fields_; }
+};
+
+// Quotes a field for CSV output when it contains a comma, quote or newline,
+// doubling embedded quotes. Uses the same block scanner as CsvReader.
+class CsvEscaper {
+public:
+    static void append(std::string& out, std::string_view field) {
+        std::uint64_t special = 0;
+        for (std::size_t base = 0; base < field.size() && special == 0; base += CsvScanner::BLOCK_SIZE) {
+            CsvBlockMasks masks = CsvScanner::classify(field.substr(base, CsvScanner::BLOCK_SIZE));
+            special = masks.quotes | masks.commas | masks.newlines;
+        }
+        if (special == 0) {
+            out.append(field);
+            return;
+        }
+
+        out += '"';
+        for (std::size_t base = 0; base < field.size(); base += CsvScanner::BLOCK_SIZE) {
+            std::string_view block = field.substr(base, CsvScanner::BLOCK_SIZE);
+            std::uint64_t quotes = CsvScanner::classify(block).quotes;
+            std::size_t copied = 0;
+            while (quotes != 0) {
+                std::size_t quote = static_cast<std::size_t>(std::countr_zero(quotes)) + 1;
+                out.append(block.substr(copied, quote - copied));
+                out += '"';
+                copied = quote;
+                quotes &= quotes - 1;
+            }
+            out.append(block.substr(copied));
+        }
+        out += '"';
+    }
+
+    static std::string escape(std::string_view field) {
+        std::string out;
+        append(out, field);
+        return out;
+    }
+};
+
+// Writes CSV records through one large reusable buffer that is flushed to the
+// file in big blocks. Numbers are formatted with std::to_chars (shortest text
+// that reads back to the same value), so nothing is allocated per field.
+class CsvWriter {
+public:
+    static constexpr std::size_t BUFFER_SIZE = 1 << 20;
+
+private:
+    std::FILE* file_ = nullptr;
+    std::string buffer_;
+    bool firstField_ = true;
+    bool failed_ = false;
+
+    void separate() {
+        if (!firstField_) buffer_ += ',';
+        firstField_ = false;
+    }
+
+    void flush() {
+        if (!buffer_.empty() && !failed_ &&
+            std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+            failed_ = true;
+        }
+        buffer_.clear();
+    }
+
+public:
+    CsvWriter() = default;
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    ~CsvWriter() {
+        close();
+    }
+
+    bool open(const std::string& filename) {
+        close();
+        file_ = std::fopen(filename.c_str(), "wb");
+        failed_ = file_ == nullptr;
+        buffer_.reserve(BUFFER_SIZE + 4096);
+        return file_ != nullptr;
+    }
+
+    // Flushes and closes the file; returns false if any write failed
+    bool close() {
+        if (file_ == nullptr) return false;
+        flush();
+        failed_ |= std::fclose(file_) != 0;
+        file_ = nullptr;
+        return !failed_;
+    }
+
+    // Appends a field, quoting it if it contains separators or quotes
+    void field(std::string_view text) {
+        separate();
+        CsvEscaper::append(buffer_, text);
+    }
+
+    // Appends text that is known not to need quoting (names, timestamps, or
+    // several pre-joined fields)
+    void rawField(std::string_view text) {
+        separate();
+        buffer_.append(text);
+    }
+
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void field(T value) {
+        separate();
+        char digits[32];
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer_.append(digits, ec == std::errc{} ? end : digits);
+    }
+
+    void endRecord() {
+        buffer_ += '\n';
+        firstField_ = true;
+        if (buffer_.size() >= BUFFER_SIZE) flush();
+    }
+};
+
+// Reads a CSV file in bounded memory. Each call to next() yields a block of
+// whole records; a record cut by the end of a read is carried over to the next
+// block. Memory use is about one block plus the longest record.
+class CsvBlockReader {
+public:
+    static constexpr std::size_t BLOCK_SIZE = 4 << 20;
+
+private:
+    std::FILE* file_ = nullptr;
+    std::size_t blockSize_ = BLOCK_SIZE;
+    std::string buffer_;
+    std::size_t consumed_ = 0;
+    std::size_t bytesRead_ = 0;
+    bool eof_ = false;
+    bool failed_ = false;
+
+    // Offset just past the last newline outside quotes, or 0 if there is none.
+    // `data` must start at a record boundary.
+    static std::size_t lastRecordEnd(std::string_view data) {
+        bool inQuotes = (std::ranges::count(data, '"') & 1) != 0;
+        for (std::size_t i = data.size(); i-- > 0;) {
+            if (data[i] == '"') {
+                inQuotes = !inQuotes;
+            } else if (data[i] == '\n' && !inQuotes) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    void readBlock() {
+        std::size_t size = buffer_.size();
+        buffer_.resize(size + blockSize_);
+        std::size_t read = std::fread(buffer_.data() + size, 1, blockSize_, file_);
+        buffer_.resize(size + read);
+        bytesRead_ += read;
+        if (read < blockSize_) {
+            eof_ = true;
+            failed_ = std::ferror(file_) != 0;
+        }
+    }
+
+public:
+    CsvBlockReader() = default;
+    CsvBlockReader(const CsvBlockReader&) = delete;
+    CsvBlockReader& operator=(const CsvBlockReader&) = delete;
+
+    ~CsvBlockReader() {
+        if (file_ != nullptr) std::fclose(file_);
+    }
+
+    bool open(const std::string& filename, std::size_t blockSize = BLOCK_SIZE) {
+        if (file_ != nullptr) std::fclose(file_);
+        file_ = std::fopen(filename.c_str(), "rb");
+        blockSize_ = std::max<std::size_t>(blockSize, 1);
+        buffer_.clear();
+        consumed_ = 0;
+        bytesRead_ = 0;
+        eof_ = file_ == nullptr;
+        failed_ = file_ == nullptr;
+        return file_ != nullptr;
+    }
+
+    // Points `block` at the next run of whole records, valid until the next
+    // call; returns false at the end of the file or on a read error
+    bool next(std::string_view& block) {
+        buffer_.erase(0, consumed_);
+        consumed_ = 0;
+        while (!failed_) {
+            if (!eof_) readBlock();
+            std::size_t end = eof_ ? buffer_.size() : lastRecordEnd(buffer_);
+            if (end > 0) {
+                block = std::string_view(buffer_).substr(0, end);
+                consumed_ = end;
+                return true;
+            }
+            if (eof_) break;
+        }
+        return false;
+    }
+
+    bool hasFailed() const { return failed_; }
+    std::size_t getBytesRead() const { return bytesRead_; }
+};
+
+// Cuts CSV text into chunks that can be parsed independently. Every cut lands just
+// after a newline that is not inside a quoted field, so no record straddles two
+// chunks. The quote state at each nominal cut comes from the parity of quote
+// characters before it, counted for all chunks in parallel.
+class CsvChunker {
+public:
+    // Returns chunk start offsets; chunk i spans [starts[i], starts[i + 1]) and the
+    // last one ends at data.size(). Some chunks may be empty.
+    static std::vector<std::size_t> split(std::string_view data, std::size_t chunks, unsigned threads) {
+        chunks = std::max<std::size_t>(1, std::min(chunks, data.size()));
+        std::vector<std::size_t> nominal(chunks + 1);
+        for (std::size_t i = 0; i <= chunks; ++i) {
+            nominal[i] = data.size() / chunks * i;
+        }
+        nominal[chunks] = data.size();
+
+        std::vector<std::uint8_t> oddQuotes(chunks);
+        Parallel::forEach(chunks, threads, [&](std::size_t i) {
+            std::string_view part = data.substr(nominal[i], nominal[i + 1] - nominal[i]);
+            oddQuotes[i] = static_cast<std::uint8_t>(std::ranges::count(part, '"') & 1);
+        });
+
+        std::vector<std::size_t> starts{0};
+        bool inQuotes = false;
+        for (std::size_t i = 1; i < chunks; ++i) {
+            inQuotes ^= oddQuotes[i - 1] != 0;
+            std::size_t start = nextRecordStart(data, nominal[i], inQuotes);
+            starts.push_back(std::max(start, starts.back()));
+        }
+        return starts;
+    }
+
+private:
+    // First record boundary at or after `pos`, given the quote state just before `pos`
+    static std::size_t nextRecordStart(std::string_view data, std::size_t pos, bool inQuotes) {
+        if (pos > 0 && data[pos - 1] == '\n' && !inQuotes) {
+            return pos;
+        }
+        for (std::size_t i = pos; i < data.size(); ++i) {
+            if (data[i] == '"') {
+                inQuotes = !inQuotes;
+            } else if (data[i] == '\n' && !inQuotes) {
+                return i + 1;
+            }
+        }
+        return data.size();
+    }
+};
+
+} // namespace budget
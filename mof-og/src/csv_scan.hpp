@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "simd.hpp"
+
+namespace budget {
+
+// Positions of CSV structural characters within one 64-byte block; bit i
+// corresponds to byte i of the block.
+struct CsvBlockMasks {
+    std::uint64_t quotes = 0;
+    std::uint64_t commas = 0;
+    std::uint64_t newlines = 0;
+};
+
+// Structural indexer in the style of simdjson: classifies 64 bytes at a time
+// into quote/comma/newline bitmasks, and turns the quote mask into an
+// "inside quotes" mask with a prefix XOR (a carry-less multiply by all-ones
+// where PCLMULQDQ is available). Implementations are chosen once at runtime.
+class CsvScanner {
+public:
+    static constexpr std::size_t BLOCK_SIZE = 64;
+
+    using ClassifyFn = CsvBlockMasks (*)(const char* block);
+    using PrefixXorFn = std::uint64_t (*)(std::uint64_t bits);
+
+    // Classifies exactly BLOCK_SIZE readable bytes
+    static CsvBlockMasks classify(const char* block) {
+        return selected().classify(block);
+    }
+
+    // Classifies up to BLOCK_SIZE bytes, padding a short tail with zeros
+    static CsvBlockMasks classify(std::string_view bytes) {
+        if (bytes.size() >= BLOCK_SIZE) {
+            return classify(bytes.data());
+        }
+        char padded[BLOCK_SIZE] = {};
+        std::memcpy(padded, bytes.data(), bytes.size());
+        return classify(padded);
+    }
+
+    // Bit i of the result is the XOR of bits 0..i of the input
+    static std::uint64_t prefixXor(std::uint64_t bits) {
+        return selected().prefixXor(bits);
+    }
+
+    static std::string_view getIsaName() {
+        return selected().name;
+    }
+
+    static CsvBlockMasks classifyScalar(const char* block) {
+        CsvBlockMasks masks;
+        for (std::size_t i = 0; i < BLOCK_SIZE; ++i) {
+            std::uint64_t bit = std::uint64_t{1} << i;
+            masks.quotes |= block[i] == '"' ? bit : 0;
+            masks.commas |= block[i] == ',' ? bit : 0;
+            masks.newlines |= block[i] == '\n' ? bit : 0;
+        }
+        return masks;
+    }
+
+    static std::uint64_t prefixXorScalar(std::uint64_t bits) {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+#ifdef BUDGET_X86_SIMD
+    __attribute__((target("sse2")))
+    static CsvBlockMasks classifySse2(const char* block) {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i newline = _mm_set1_epi8('\n');
+        CsvBlockMasks masks;
+        for (std::size_t i = 0; i < BLOCK_SIZE; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+            masks.quotes |= toBits(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote))) << i;
+            masks.commas |= toBits(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, comma))) << i;
+            masks.newlines |= toBits(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))) << i;
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx2")))
+    static CsvBlockMasks classifyAvx2(const char* block) {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i comma = _mm256_set1_epi8(',');
+        const __m256i newline = _mm256_set1_epi8('\n');
+        __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+        CsvBlockMasks masks;
+        masks.quotes = toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, quote))) |
+                       toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, quote))) << 32;
+        masks.commas = toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, comma))) |
+                       toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, comma))) << 32;
+        masks.newlines = toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))) |
+                         toBits(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline))) << 32;
+        return masks;
+    }
+
+    __attribute__((target("pclmul,sse2")))
+    static std::uint64_t prefixXorClmul(std::uint64_t bits) {
+        __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<long long>(bits)),
+                                               _mm_set1_epi8(static_cast<char>(0xFF)), 0);
+        return static_cast<std::uint64_t>(_mm_cvtsi128_si64(product));
+    }
+#endif
+
+private:
+    struct Selection {
+        ClassifyFn classify;
+        PrefixXorFn prefixXor;
+        std::string_view name;
+    };
+
+    static const Selection& selected() {
+        static const Selection selection = detect();
+        return selection;
+    }
+
+    static Selection detect() {
+#ifdef BUDGET_X86_SIMD
+        __builtin_cpu_init();
+        PrefixXorFn prefixXor = __builtin_cpu_supports("pclmul") ? &prefixXorClmul : &prefixXorScalar;
+        if (__builtin_cpu_supports("avx2")) return {&classifyAvx2, prefixXor, "avx2"};
+        return {&classifySse2, prefixXor, "sse2"};
+#else
+        return {&classifyScalar, &prefixXorScalar, "scalar"};
+#endif
+    }
+
+    static std::uint64_t toBits(int movemask) {
+        return static_cast<std::uint32_t>(movemask);
+    }
+};
+
+} // namespace budget
@@ -1,57 +1,163 @@
 #pragma once
 
-#include <string>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
 #include <string_view>
 #include <stdexcept>
 
+#include "enum_table.hpp"
+#include "money.hpp"
+
 namespace budget {
 
-enum class Currency {
-    GBP,
-    USD
+// X(code, symbol, default rate in units per one BASE_CURRENCY). New currencies
+// go at the end: files and snapshots store the enum value.
+#define BUDGET_CURRENCIES(X) \
+    X(GBP, "£", 1.0)         \
+    X(USD, "$", 1.38)        \
+    X(EUR, "€", 1.17)        \
+    X(JPY, "¥", 190.0)       \
+    X(CHF, "CHF ", 1.12)     \
+    X(CAD, "C$", 1.85)       \
+    X(AUD, "A$", 2.05)       \
+    X(INR, "₹", 113.0)
+
+enum class Currency : std::uint8_t {
+#define BUDGET_CURRENCY_ENUMERATOR(code, symbol, rate) code,
+    BUDGET_CURRENCIES(BUDGET_CURRENCY_ENUMERATOR)
+#undef BUDGET_CURRENCY_ENUMERATOR
 };
 
+inline constexpr auto ALL_CURRENCIES = std::to_array<Currency>({
+#define BUDGET_CURRENCY_VALUE(code, symbol, rate) Currency::code,
+    BUDGET_CURRENCIES(BUDGET_CURRENCY_VALUE)
+#undef BUDGET_CURRENCY_VALUE
+});
+
+inline constexpr std::size_t CURRENCY_COUNT = ALL_CURRENCIES.size();
+
+// Every rate is quoted as units of a currency per one unit of the base currency
+inline constexpr Currency BASE_CURRENCY = Currency::GBP;
+
+inline constexpr EnumNameTable<Currency, CURRENCY_COUNT> CURRENCY_CODES{std::to_array<std::string_view>({
+#define BUDGET_CURRENCY_CODE(code, symbol, rate) #code,
+    BUDGET_CURRENCIES(BUDGET_CURRENCY_CODE)
+#undef BUDGET_CURRENCY_CODE
+})};
+
+inline constexpr auto CURRENCY_SYMBOLS = std::to_array<std::string_view>({
+#define BUDGET_CURRENCY_SYMBOL(code, symbol, rate) symbol,
+    BUDGET_CURRENCIES(BUDGET_CURRENCY_SYMBOL)
+#undef BUDGET_CURRENCY_SYMBOL
+});
+
+inline constexpr auto DEFAULT_RATES = std::to_array<double>({
+#define BUDGET_CURRENCY_RATE(code, symbol, rate) rate,
+    BUDGET_CURRENCIES(BUDGET_CURRENCY_RATE)
+#undef BUDGET_CURRENCY_RATE
+});
+
 class CurrencyConverter {
+private:
+    static constexpr std::size_t index(Currency currency) {
+        auto i = static_cast<std::size_t>(currency);
+        if (i >= CURRENCY_COUNT) throw std::invalid_argument("Invalid currency");
+        return i;
+    }
+
 public:
-    static std::string toString(Currency currency) {
-        switch (currency) {
-            case Currency::GBP: return "GBP";
-            case Currency::USD: return "USD";
-        }
-        throw std::invalid_argument("Invalid currency");
+    static constexpr std::string_view toString(Currency currency) {
+        return CURRENCY_CODES.name(currency);
+    }
+
+    // Case-insensitive
+    static constexpr std::optional<Currency> tryFromString(std::string_view str) noexcept {
+        return CURRENCY_CODES.find(str);
     }
 
     static Currency fromString(std::string_view str) {
-        if (str == "GBP" || str == "gbp") return Currency::GBP;
-        if (str == "USD" || str == "usd") return Currency::USD;
+        if (auto currency = tryFromString(str)) return *currency;
         throw std::invalid_argument("Invalid currency string");
     }
 
-    static std::string getSymbol(Currency currency) {
-        switch (currency) {
-            case Currency::GBP: return "£";
-            case Currency::USD: return "$";
+    static constexpr std::string_view getSymbol(Currency currency) {
+        return CURRENCY_SYMBOLS[index(currency)];
+    }
+
+    static constexpr const std::array<Currency, CURRENCY_COUNT>& getAllCurrencies() {
+        return ALL_CURRENCIES;
+    }
+};
+
+static_assert(CurrencyConverter::tryFromString("eur") == Currency::EUR);
+static_assert(CurrencyConverter::toString(Currency::INR) == "INR");
+
+// Exchange rates between every pair of currencies. Each currency is quoted
+// against BASE_CURRENCY; the quotes are expanded into a dense from-to matrix so
+// a conversion is one lookup and one multiply, never a chain through the base.
+class CurrencyRates {
+private:
+    std::array<double, CURRENCY_COUNT> perBase_{};
+    std::array<std::array<double, CURRENCY_COUNT>, CURRENCY_COUNT> matrix_{};
+
+    static std::size_t index(Currency currency) { return static_cast<std::size_t>(currency); }
+
+    void rebuild() {
+        for (std::size_t from = 0; from < CURRENCY_COUNT; ++from) {
+            for (std::size_t to = 0; to < CURRENCY_COUNT; ++to) {
+                matrix_[from][to] = from == to ? 1.0 : perBase_[to] / perBase_[from];
+            }
         }
-        throw std::invalid_argument("Invalid currency");
     }
 
-    static double convert(double amount, const double exchangeRate, Currency from, Currency to) {
-        if (from == to) {
-            return amount;
+public:
+    CurrencyRates() {
+        perBase_ = DEFAULT_RATES;
+        rebuild();
+    }
+
+    // `unitsPerBase` of `currency` buy one BASE_CURRENCY; the base itself is fixed at 1
+    void setRate(Currency currency, double unitsPerBase) {
+        if (!(unitsPerBase > 0.0) || !std::isfinite(unitsPerBase)) {
+            throw std::invalid_argument("Exchange rate must be positive");
         }
-        // Example conversion rates
-        const double GBP_TO_USD = exchangeRate;
-        const double USD_TO_GBP = 1.0 / GBP_TO_USD;
-
-        if (from == Currency::GBP && to == Currency::USD) {
-            return amount * GBP_TO_USD;
-        } else if (from == Currency::USD && to == Currency::GBP) {
-            return amount * USD_TO_GBP;
-        } else {
-            return amount; // same currency, no conversion needed
+        if (currency == BASE_CURRENCY && unitsPerBase != 1.0) {
+            throw std::invalid_argument("The base currency rate is always 1");
         }
+        perBase_[index(currency)] = unitsPerBase;
+        rebuild();
+    }
 
-        throw std::invalid_argument("Invalid currency conversion");
+    double getRate(Currency currency) const {
+        return perBase_[index(currency)];
+    }
+
+    // Units of `to` per one unit of `from`
+    double getRate(Currency from, Currency to) const {
+        return matrix_[index(from)][index(to)];
+    }
+
+    Money convert(Money amount, Currency from, Currency to) const {
+        if (from == to) return amount;
+        return Money::fromMinorRounded(static_cast<double>(amount.getMinor()) * getRate(from, to));
+    }
+
+    // Converts a whole column at one rate; `out` must be at least as long as `in`
+    // and may be the same span
+    void convert(std::span<const Money> in, std::span<Money> out, Currency from, Currency to) const {
+        if (from == to) {
+            if (in.data() != out.data()) std::copy(in.begin(), in.end(), out.begin());
+            return;
+        }
+        const double rate = getRate(from, to);
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = Money::fromMinorRounded(static_cast<double>(in[i].getMinor()) * rate);
+        }
     }
 };
 
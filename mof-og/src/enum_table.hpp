@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+namespace budget {
+
+constexpr char asciiLower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) return false;
+    }
+    return true;
+}
+
+// Case-insensitive name to enum lookup through a perfect hash found at compile
+// time: a seed is searched for under which every name lands in its own slot, so
+// a lookup is one hash, one slot read and one comparison. The enum's values
+// must be 0..N-1 in the order of `names`.
+template <typename Enum, std::size_t N>
+class EnumNameTable {
+private:
+    static constexpr std::size_t SLOTS = std::bit_ceil(N * 2);
+    static constexpr std::uint64_t MAX_SEED = 1 << 16;
+    static_assert(N < 255, "slot entries are one byte");
+
+    std::array<std::string_view, N> names_{};
+    std::array<std::uint8_t, SLOTS> slots_{}; // name index + 1, 0 if empty
+    std::uint64_t seed_ = 0;
+
+    // FNV-1a over the lower-cased bytes, seeded
+    static constexpr std::size_t slotOf(std::string_view text, std::uint64_t seed) {
+        std::uint64_t hash = 0xcbf29ce484222325ull ^ (seed * 0x9e3779b97f4a7c15ull);
+        for (char c : text) {
+            hash = (hash ^ static_cast<unsigned char>(asciiLower(c))) * 0x100000001b3ull;
+        }
+        hash ^= hash >> 29;
+        return static_cast<std::size_t>(hash & (SLOTS - 1));
+    }
+
+    constexpr bool tryBuild(std::uint64_t seed) {
+        slots_ = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            std::size_t slot = slotOf(names_[i], seed);
+            if (slots_[slot] != 0) return false;
+            slots_[slot] = static_cast<std::uint8_t>(i + 1);
+        }
+        seed_ = seed;
+        return true;
+    }
+
+public:
+    consteval explicit EnumNameTable(const std::array<std::string_view, N>& names) : names_(names) {
+        for (std::uint64_t seed = 0; seed < MAX_SEED; ++seed) {
+            if (tryBuild(seed)) return;
+        }
+        throw std::logic_error("no perfect hash seed found; names differ only in case?");
+    }
+
+    constexpr std::optional<Enum> find(std::string_view text) const {
+        std::uint8_t entry = slots_[slotOf(text, seed_)];
+        if (entry == 0 || !equalsIgnoreCase(text, names_[entry - 1])) return std::nullopt;
+        return static_cast<Enum>(entry - 1);
+    }
+
+    constexpr std::string_view name(Enum value) const {
+        auto i = static_cast<std::size_t>(value);
+        if (i >= N) throw std::invalid_argument("Invalid enum value");
+        return names_[i];
+    }
+};
+
+} // namespace budget
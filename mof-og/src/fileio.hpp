@@ -1,169 +1,442 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <string_view>
+#include <span>
+#include <utility>
 #include <vector>
+#include <charconv>
 #include <chrono>
-#include <iomanip>
+#include <cmath>
+#include <filesystem>
 
+#include "csv.hpp"
+#include "mapped_file.hpp"
 #include "manager.hpp"
+#include "money.hpp"
+#include "parallel.hpp"
+#include "snapshot.hpp"
 #include "category.hpp"
 #include "currency.hpp"
-#include "entry.hpp"
+#include "store.hpp"
+#include "timestamp.hpp"
+#include "totals.hpp"
 
 namespace budget {
 
+struct LoadStats {
+    std::size_t bytes = 0;
+    std::size_t entries = 0;
+    std::size_t chunks = 0;
+    std::size_t threads = 0;
+    double seconds = 0.0;
+
+    double getMegabytesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+struct LoadOptions {
+    unsigned threads = 1;                    // 0 = one per hardware thread
+    std::size_t minChunkBytes = 1 << 20;     // smaller files are not worth splitting further
+    LoadStats* stats = nullptr;              // filled in after a successful load
+};
+
+// Category totals and incomes rolled up over one or more budget files. Incomes
+// are added up per file, since each file carries its own monthly figures.
+// Rates are those of the last file read, which reports convert at.
+struct BudgetSummary {
+    CategoryTotals totals;
+    CurrencyRates rates;
+    Money babuIncome;
+    Money mamuIncome;
+    std::size_t files = 0;
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+
+    Money getIncome() const {
+        return babuIncome + mamuIncome;
+    }
+};
+
 class FileIO {
 private:
-    static constexpr const char* METADATA_PREFIX = "#META:";
+    static constexpr std::string_view METADATA_PREFIX = "#META:";
 
 public:
     static bool saveBudget(const BudgetManager& manager, const std::string& filename) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
+        CsvWriter writer;
+        if (!writer.open(filename)) {
             return false;
         }
 
         // Write metadata (exchange rate and income values)
-        file << METADATA_PREFIX << "EXCHANGE_RATE," << manager.getExchangeRate() << "\n";
-        file << METADATA_PREFIX << "BABU_INCOME," << manager.getBabuIncome() << "\n";
-        file << METADATA_PREFIX << "MAMU_INCOME," << manager.getMamuIncome() << "\n";
+        // Rates: EXCHANGE_RATE is the GBP to USD rate older versions read
+        writeMetadata(writer, "EXCHANGE_RATE", manager.getExchangeRate());
+        for (auto currency : CurrencyConverter::getAllCurrencies()) {
+            if (currency == BASE_CURRENCY || currency == Currency::USD) continue;
+            writeMetadata(writer, std::string("RATE_").append(CurrencyConverter::toString(currency)),
+                          manager.getRate(currency));
+        }
+        writeMetadata(writer, "BABU_INCOME", manager.getBabuIncome().toDouble());
+        writeMetadata(writer, "MAMU_INCOME", manager.getMamuIncome().toDouble());
 
         // Write header
-        file << "ID,Description,Amount,Category,Currency,Timestamp\n";
+        writer.rawField("ID,Description,Amount,Category,Currency,Timestamp");
+        writer.endRecord();
 
         // Write entries
+        TimestampFormatter timestamps;
         for (const auto& entry : manager.getEntries()) {
-            file << entry->getId() << ","
-                 << escapeCSV(entry->getDescription()) << ","
-                 << entry->getAmount() << ","
-                 << CategoryManager::toString(entry->getCategory()) << ","
-                 << CurrencyConverter::toString(entry->getCurrency()) << ","
-                 << formatTimestamp(entry->getTimestamp()) << "\n";
+            writer.field(entry.getId());
+            writer.field(entry.getDescription());
+            writeMoney(writer, entry.getAmount());
+            writer.rawField(CategoryManager::toString(entry.getCategory()));
+            writer.rawField(CurrencyConverter::toString(entry.getCurrency()));
+            writer.rawField(timestamps.format(entry.getTimestamp()));
+            writer.endRecord();
         }
 
-        file.close();
-        return true;
+        return writer.close();
     }
 
     static bool loadBudget(BudgetManager& manager, const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
+        return loadBudget(manager, filename, LoadOptions{});
+    }
+
+    // Writes a binary snapshot: fixed-width columns plus a description heap,
+    // which loadSnapshot (or SnapshotView) can use without parsing
+    static bool saveSnapshot(const BudgetManager& manager, const std::string& filename) {
+        return SnapshotWriter::save(manager, filename);
+    }
+
+    static bool loadSnapshot(BudgetManager& manager, const std::string& filename) {
+        SnapshotView snapshot;
+        if (!snapshot.open(filename)) {
             return false;
         }
 
         manager.clear();
 
-        std::string line;
-        bool headerSkipped = false;
+        const SnapshotHeader& header = snapshot.getHeader();
+        for (std::size_t i = 0; i < snapshot.rates().size(); ++i) {
+            auto currency = static_cast<Currency>(i);
+            if (currency != BASE_CURRENCY && isValidRate(snapshot.rates()[i])) {
+                manager.setRate(currency, snapshot.rates()[i]);
+            }
+        }
+        if (auto income = snapshotIncome(header.babuIncome)) manager.setBabuIncome(*income);
+        if (auto income = snapshotIncome(header.mamuIncome)) manager.setMamuIncome(*income);
 
-        // Read file line by line
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
+        manager.reserve(snapshot.size());
+        for (std::size_t row = 0; row < snapshot.size(); ++row) {
+            manager.restoreEntry(snapshot.ids()[row], snapshot.description(row), snapshot.amounts()[row],
+                                 snapshot.categories()[row], snapshot.currencies()[row], snapshot.timestamp(row));
+        }
+        manager.reserveIdsBelow(header.nextId);
+        return true;
+    }
 
-            // Check for metadata lines
-            if (line.rfind(METADATA_PREFIX, 0) == 0) {
-                parseMetadataLine(manager, line.substr(strlen(METADATA_PREFIX)));
-                continue;
-            }
+    // Loads either format, telling them apart by the snapshot magic bytes
+    static bool loadAny(BudgetManager& manager, const std::string& filename, const LoadOptions& options = {}) {
+        if (SnapshotView::isSnapshot(filename)) {
+            return loadSnapshot(manager, filename);
+        }
+        return loadBudget(manager, filename, options);
+    }
 
-            // Skip header line (starts with "ID,")
-            if (!headerSkipped && line.rfind("ID,", 0) == 0) {
-                headerSkipped = true;
-                continue;
+    // Adds the totals and incomes of each file (CSV or snapshot) to `summary`
+    // without loading the entries. CSV files are streamed block by block, so
+    // memory use stays bounded however large the files are. Rows are counted
+    // exactly as loadBudget would count them.
+    static bool summarize(std::span<const std::string> filenames, BudgetSummary& summary,
+                          std::size_t blockBytes = CsvBlockReader::BLOCK_SIZE) {
+        for (const auto& filename : filenames) {
+            if (!summarizeFile(filename, summary, blockBytes)) {
+                return false;
             }
+        }
+        return true;
+    }
 
-            // Parse entry line
-            auto parts = parseCSVLine(line);
-            if (parts.size() != 6) continue;
+    // Loads a budget, optionally parsing the file on several threads. The result is
+    // identical to a single-threaded load: chunks are merged in file order, so
+    // metadata and ID assignment do not depend on the thread count.
+    static bool loadBudget(BudgetManager& manager, const std::string& filename, const LoadOptions& options) {
+        auto started = std::chrono::steady_clock::now();
+        MappedFile file;
+        if (!file.open(filename)) {
+            return false;
+        }
 
-            try {
-                std::string id = parts[0];
-                std::string description = parts[1];
-                double amount = std::stod(parts[2]);
-                Category category = CategoryManager::fromString(parts[3]);
-                Currency currency = CurrencyConverter::fromString(parts[4]);
+        manager.clear();
 
-                manager.addEntry(std::move(description), amount, category, currency);
-            } catch (...) {
-                // Skip invalid entries
-                continue;
+        std::string_view data = file.view();
+        unsigned threads = Parallel::resolveThreads(options.threads);
+        std::size_t chunks =
+            std::min<std::size_t>(threads, data.size() / std::max<std::size_t>(options.minChunkBytes, 1) + 1);
+
+        if (chunks <= 1) {
+            ManagerSink sink{manager};
+            parseRecords(data, sink);
+        } else {
+            // Parse chunks into buffers in parallel, then merge them in file order
+            std::vector<std::size_t> starts = CsvChunker::split(data, chunks, threads);
+            std::vector<ChunkSink> parsed(starts.size());
+            Parallel::forEach(starts.size(), threads, [&](std::size_t i) {
+                std::size_t end = i + 1 < starts.size() ? starts[i + 1] : data.size();
+                parseRecords(data.substr(starts[i], end - starts[i]), parsed[i]);
+            });
+
+            std::size_t rows = 0;
+            for (const auto& chunk : parsed) rows += chunk.rows.size();
+            manager.reserve(rows);
+            for (const auto& chunk : parsed) {
+                chunk.mergeInto(manager);
             }
+            chunks = starts.size();
         }
 
-        file.close();
+        if (options.stats != nullptr) {
+            options.stats->bytes = data.size();
+            options.stats->entries = manager.getEntryCount();
+            options.stats->chunks = chunks;
+            options.stats->threads = std::min<std::size_t>(threads, chunks);
+            options.stats->seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        }
         return true;
     }
 
 private:
-    static void parseMetadataLine(BudgetManager& manager, const std::string& metaLine) {
-        auto parts = parseCSVLine(metaLine);
-        if (parts.size() != 2) return;
+    // Receives parsed records and applies them straight to the manager
+    struct ManagerSink {
+        BudgetManager& manager;
+
+        void metadata(std::string_view key, double value) {
+            applyMetadata(manager, key, value);
+        }
+
+        void entry(EntryId id, std::string_view description, Money amount, Category category,
+                   Currency currency, std::chrono::system_clock::time_point timestamp) {
+            manager.restoreEntry(id, description, amount, category, currency, timestamp);
+        }
+    };
+
+    // Buffers the records of one chunk until it can be merged in file order
+    struct ChunkSink {
+        struct Row {
+            EntryId id;
+            Money amount;
+            Category category;
+            Currency currency;
+            std::chrono::system_clock::time_point timestamp;
+            std::size_t descriptionEnd;
+        };
+
+        std::vector<std::pair<std::string_view, double>> metadataValues;
+        std::vector<Row> rows;
+        std::string descriptions;
+
+        void metadata(std::string_view key, double value) {
+            metadataValues.emplace_back(key, value);
+        }
 
-        try {
-            const std::string& key = parts[0];
-            double value = std::stod(parts[1]);
+        void entry(EntryId id, std::string_view description, Money amount, Category category,
+                   Currency currency, std::chrono::system_clock::time_point timestamp) {
+            descriptions.append(description);
+            rows.push_back(Row{id, amount, category, currency, timestamp, descriptions.size()});
+        }
 
-            if (key == "EXCHANGE_RATE") {
-                manager.setExchangeRate(value);
-            } else if (key == "BABU_INCOME") {
-                manager.setBabuIncome(value);
-            } else if (key == "MAMU_INCOME") {
-                manager.setMamuIncome(value);
+        void mergeInto(BudgetManager& manager) const {
+            for (const auto& [key, value] : metadataValues) {
+                applyMetadata(manager, key, value);
+            }
+            std::size_t descriptionStart = 0;
+            for (const auto& row : rows) {
+                std::string_view description(descriptions.data() + descriptionStart,
+                                             row.descriptionEnd - descriptionStart);
+                manager.restoreEntry(row.id, description, row.amount, row.category, row.currency,
+                                     row.timestamp);
+                descriptionStart = row.descriptionEnd;
             }
-        } catch (...) {
-            // Ignore invalid metadata, use defaults
         }
-    }
+    };
+
+    // Folds records into running totals; incomes start from the manager defaults
+    struct SummarySink {
+        CategoryTotals totals;
+        Money babuIncome;
+        Money mamuIncome;
+        CurrencyRates rates{};
+        std::size_t entries = 0;
+
+        void metadata(std::string_view key, double value) {
+            if (auto currency = rateCurrency(key); currency && isValidRate(value)) {
+                rates.setRate(*currency, value);
+            } else if (key == "BABU_INCOME" && value >= 0.0) {
+                babuIncome = Money::fromMajor(value);
+            } else if (key == "MAMU_INCOME" && value >= 0.0) {
+                mamuIncome = Money::fromMajor(value);
+            }
+        }
+
+        void entry(EntryId, std::string_view, Money amount, Category category, Currency currency,
+                   std::chrono::system_clock::time_point) {
+            totals.add(category, currency, amount);
+            ++entries;
+        }
+    };
 
-    static std::string escapeCSV(const std::string& str) {
-        if (str.find(',') != std::string::npos || 
-            str.find('"') != std::string::npos || 
-            str.find('\n') != std::string::npos) {
-            std::string escaped = "\"";
-            for (char c : str) {
-                if (c == '"') escaped += "\"\"";
-                else escaped += c;
+    static bool summarizeFile(const std::string& filename, BudgetSummary& summary, std::size_t blockBytes) {
+        if (SnapshotView::isSnapshot(filename)) {
+            SnapshotView snapshot;
+            if (!snapshot.open(filename)) {
+                return false;
+            }
+            const SnapshotHeader& header = snapshot.getHeader();
+            summary.totals.merge(CategoryTotals::compute(
+                HistogramInput{snapshot.amounts(), snapshot.categories(), snapshot.currencies()}));
+            for (std::size_t i = 0; i < snapshot.rates().size(); ++i) {
+                auto currency = static_cast<Currency>(i);
+                if (currency != BASE_CURRENCY && isValidRate(snapshot.rates()[i])) {
+                    summary.rates.setRate(currency, snapshot.rates()[i]);
+                }
             }
-            escaped += "\"";
-            return escaped;
+            const BudgetManager defaults;
+            summary.babuIncome += snapshotIncome(header.babuIncome).value_or(defaults.getBabuIncome());
+            summary.mamuIncome += snapshotIncome(header.mamuIncome).value_or(defaults.getMamuIncome());
+            summary.entries += snapshot.size();
+            summary.bytes += std::filesystem::file_size(filename);
+            ++summary.files;
+            return true;
         }
-        return str;
+
+        CsvBlockReader reader;
+        if (!reader.open(filename, blockBytes)) {
+            return false;
+        }
+        const BudgetManager defaults;
+        SummarySink sink{{}, defaults.getBabuIncome(), defaults.getMamuIncome()};
+        std::string_view block;
+        while (reader.next(block)) {
+            parseRecords(block, sink);
+        }
+        if (reader.hasFailed()) {
+            return false;
+        }
+
+        summary.totals.merge(sink.totals);
+        summary.rates = sink.rates;
+        summary.babuIncome += sink.babuIncome;
+        summary.mamuIncome += sink.mamuIncome;
+        summary.entries += sink.entries;
+        summary.bytes += reader.getBytesRead();
+        ++summary.files;
+        return true;
     }
 
-    static std::vector<std::string> parseCSVLine(const std::string& line) {
-        std::vector<std::string> parts;
-        std::string current;
-        bool inQuotes = false;
+    // Parses every record in `text` into `sink`; fields are views into `text`
+    template <typename Sink>
+    static void parseRecords(std::string_view text, Sink& sink) {
+        CsvReader reader(text);
+        TimestampParser timestamps;
 
-        for (size_t i = 0; i < line.size(); ++i) {
-            char c = line[i];
+        while (reader.next()) {
+            std::string_view record = reader.record();
+            if (record.empty()) continue;
 
-            if (c == '"') {
-                if (inQuotes && i + 1 < line.size() && line[i + 1] == '"') {
-                    current += '"';
-                    ++i;
-                } else {
-                    inQuotes = !inQuotes;
-                }
-            } else if (c == ',' && !inQuotes) {
-                parts.push_back(current);
-                current.clear();
-            } else {
-                current += c;
+            // Check for metadata lines
+            if (record.starts_with(METADATA_PREFIX)) {
+                parseMetadataLine(sink, reader.fields());
+                continue;
             }
+
+            // Parse entry line; the header line ("ID,Description,Amount,...") and other
+            // invalid entries fail validation and are skipped
+            parseEntryLine(sink, reader.fields(), timestamps);
+        }
+    }
+
+    template <typename Sink>
+    static void parseMetadataLine(Sink& sink, std::span<const std::string_view> parts) {
+        if (parts.size() != 2) return;
+
+        double value = 0.0;
+        if (!parseNumber(parts[1], value)) return; // Ignore invalid metadata, use defaults
+        sink.metadata(parts[0].substr(METADATA_PREFIX.size()), value);
+    }
+
+    // The currency a rate key sets: "EXCHANGE_RATE" (GBP to USD, as older files
+    // have it) or "RATE_<code>"; nullopt for other keys and for the base currency
+    static std::optional<Currency> rateCurrency(std::string_view key) {
+        if (key == "EXCHANGE_RATE") return Currency::USD;
+        if (!key.starts_with("RATE_")) return std::nullopt;
+        auto currency = CurrencyConverter::tryFromString(key.substr(5));
+        if (currency == BASE_CURRENCY) return std::nullopt;
+        return currency;
+    }
+
+    // A snapshot header's income, or nullopt if it is negative and so ignored,
+    // as a negative income in a CSV file is
+    static std::optional<Money> snapshotIncome(std::int64_t minor) {
+        if (minor < 0) return std::nullopt;
+        return Money::fromMinor(minor);
+    }
+
+    static bool isValidRate(double rate) {
+        return rate > 0.0 && std::isfinite(rate);
+    }
+
+    static void applyMetadata(BudgetManager& manager, std::string_view key, double value) {
+        if (auto currency = rateCurrency(key); currency && isValidRate(value)) {
+            manager.setRate(*currency, value);
+        } else if (key == "BABU_INCOME" && value >= 0.0) {
+            manager.setBabuIncome(Money::fromMajor(value));
+        } else if (key == "MAMU_INCOME" && value >= 0.0) {
+            manager.setMamuIncome(Money::fromMajor(value));
         }
-        parts.push_back(current);
+    }
+
+    template <typename Sink>
+    static void parseEntryLine(Sink& sink, std::span<const std::string_view> parts,
+                               TimestampParser& timestamps) {
+        if (parts.size() != 6) return;
+
+        auto amount = Money::parse(parts[2]);
+        auto category = CategoryManager::tryFromString(parts[3]);
+        auto currency = CurrencyConverter::tryFromString(parts[4]);
+        if (!amount || !category || !currency) return;
+
+        // IDs that are not plain numbers (or clash) get a fresh one from the manager
+        EntryId id = 0;
+        if (!parseNumber(parts[0], id)) id = 0; // from_chars stores the digits before any junk
+        auto timestamp = timestamps.parse(parts[5]).value_or(std::chrono::system_clock::now());
+
+        sink.entry(id, parts[1], *amount, *category, *currency, timestamp);
+    }
+
+    template <typename T>
+    static bool parseNumber(std::string_view text, T& value) {
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return ec == std::errc{} && ptr == text.data() + text.size();
+    }
 
-        return parts;
+    static void writeMoney(CsvWriter& writer, Money amount) {
+        char text[Money::MAX_CHARS];
+        writer.rawField(std::string_view(text, amount.toChars(text, text + sizeof(text))));
     }
 
-    static std::string formatTimestamp(const std::chrono::system_clock::time_point& tp) {
-        auto time_t = std::chrono::system_clock::to_time_t(tp);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        return ss.str();
+    static void writeMetadata(CsvWriter& writer, std::string_view key, double value) {
+        std::string name(METADATA_PREFIX);
+        name.append(key);
+        writer.rawField(name);
+        writer.field(value);
+        writer.endRecord();
     }
 };
 
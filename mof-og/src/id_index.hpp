@@ -0,0 +1,73 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace budget {
+
+using EntryId = std::uint32_t;
+
+// Constant-time map from entry ID to its row in the EntryStore.
+// IDs handed out by BudgetManager are dense (1, 2, 3, ...), so they index a flat
+// slot array directly. IDs far beyond the current range (e.g. imported from an
+// old file) spill into a hash map instead of inflating the slot array.
+class IdIndex {
+public:
+    static constexpr std::uint32_t NO_ROW = UINT32_MAX;
+
+private:
+    static constexpr std::size_t DENSE_SLACK = 1024;
+
+    std::vector<std::uint32_t> slots_;
+    std::unordered_map<EntryId, std::uint32_t> sparse_;
+
+public:
+    void insert(EntryId id, std::uint32_t row) {
+        if (id < slots_.size()) {
+            slots_[id] = row;
+            return;
+        }
+        if (id <= 2 * slots_.size() + DENSE_SLACK) {
+            slots_.resize(std::max<std::size_t>(id + 1, 2 * slots_.size()), NO_ROW);
+            slots_[id] = row;
+            // IDs that spilled earlier may now fall inside the slots, where find() looks for them
+            std::erase_if(sparse_, [&](const auto& spilled) {
+                if (spilled.first >= slots_.size()) return false;
+                slots_[spilled.first] = spilled.second;
+                return true;
+            });
+            return;
+        }
+        sparse_[id] = row;
+    }
+
+    std::uint32_t find(EntryId id) const {
+        if (id < slots_.size()) {
+            return slots_[id];
+        }
+        auto it = sparse_.find(id);
+        return it != sparse_.end() ? it->second : NO_ROW;
+    }
+
+    bool contains(EntryId id) const {
+        return find(id) != NO_ROW;
+    }
+
+    void erase(EntryId id) {
+        if (id < slots_.size()) {
+            slots_[id] = NO_ROW;
+        } else {
+            sparse_.erase(id);
+        }
+    }
+
+    void clear() {
+        slots_.clear();
+        sparse_.clear();
+    }
+};
+
+} // namespace budget
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "concurrent_manager.hpp"
+#include "manager.hpp"
+
+namespace budget {
+
+// Bounded multi-producer, single-consumer queue. Each cell carries a sequence
+// number telling producers whether it is free for their ticket and the consumer
+// whether it has been filled, so producers only contend on one fetch of the
+// tail ticket and never take a lock.
+template <typename T>
+class MpscQueue {
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> tail_{0}; // next ticket handed to a producer
+    alignas(64) std::atomic<std::size_t> head_{0}; // next cell the consumer reads
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit MpscQueue(std::size_t capacity)
+        : cells_(std::make_unique<Cell[]>(std::bit_ceil(std::max<std::size_t>(capacity, 2)))),
+          mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1) {
+        for (std::size_t i = 0; i <= mask_; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Moves from `value` and returns true, or leaves it alone and returns false if full
+    bool tryPush(T& value) {
+        std::size_t ticket = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[ticket & mask_];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lag = static_cast<std::ptrdiff_t>(sequence - ticket);
+            if (lag == 0) {
+                if (tail_.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(ticket + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false; // the cell still holds the value from a lap ago
+            } else {
+                ticket = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only: moves up to `max` values, oldest first, onto `out`
+    std::size_t popBatch(std::vector<T>& out, std::size_t max) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        std::size_t popped = 0;
+        for (; popped < max; ++popped, ++head) {
+            Cell& cell = cells_[head & mask_];
+            if (cell.sequence.load(std::memory_order_acquire) != head + 1) break;
+            out.push_back(std::move(cell.value));
+            cell.sequence.store(head + mask_ + 1, std::memory_order_release);
+        }
+        head_.store(head, std::memory_order_release);
+        return popped;
+    }
+
+    // Values claimed by producers and not yet popped; approximate while they run
+    // (head_ is published after a whole batch, so tail_ can briefly run a lap ahead)
+    std::size_t size() const {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        std::size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? std::min(tail - head, capacity()) : 0;
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+};
+
+struct IngestOptions {
+    std::size_t capacity = 1 << 16; // entries queued before producers are pushed back
+    std::size_t maxBatch = 1 << 15; // entries committed per ledger update at most
+};
+
+struct IngestMetrics {
+    std::uint64_t enqueued = 0;
+    std::uint64_t committed = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t rejected = 0;    // tryPush calls refused because the queue was full
+    std::uint64_t waits = 0;       // push calls that had to wait for room
+    std::size_t depth = 0;         // entries queued right now
+    std::size_t maxDepth = 0;
+    std::chrono::nanoseconds totalCommit{0}; // time spent applying batches to the ledger
+    std::chrono::nanoseconds maxCommit{0};   // longest single batch
+
+    std::chrono::nanoseconds getMeanCommit() const {
+        if (batches == 0) return std::chrono::nanoseconds{0};
+        return totalCommit / static_cast<std::int64_t>(batches);
+    }
+};
+
+// Feeds a ConcurrentBudgetManager from any number of importer threads. Producers
+// queue pre-parsed entries without locking; one committer thread drains them in
+// batches, each applied with a single addEntries() inside a single update(), so
+// IDs are assigned in queue order and the totals, indexes and published snapshot
+// are refreshed once per batch rather than once per entry. When the queue is
+// full, push() waits for the committer and tryPush() fails.
+class IngestQueue {
+private:
+    ConcurrentBudgetManager& ledger_;
+    IngestOptions options_;
+    MpscQueue<NewEntry> queue_;
+
+    std::atomic<std::uint64_t> pushed_{0};    // entries queued so far
+    std::atomic<std::uint64_t> committed_{0}; // entries committed; producers wait on it
+    std::atomic<std::uint64_t> signal_{0};    // bumped on every push and on stop; the committer waits on it
+    std::atomic<bool> stopping_{false};
+
+    std::atomic<std::uint64_t> batches_{0};
+    std::atomic<std::uint64_t> rejected_{0};
+    std::atomic<std::uint64_t> waits_{0};
+    std::atomic<std::size_t> maxDepth_{0};
+    std::atomic<std::int64_t> totalCommitNs_{0};
+    std::atomic<std::int64_t> maxCommitNs_{0};
+
+    std::thread committer_;
+
+    void notePushed() {
+        pushed_.fetch_add(1, std::memory_order_release);
+        signal_.fetch_add(1, std::memory_order_release);
+        signal_.notify_one();
+        std::size_t depth = queue_.size();
+        std::size_t seen = maxDepth_.load(std::memory_order_relaxed);
+        while (depth > seen && !maxDepth_.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {}
+    }
+
+    void commitLoop() {
+        std::vector<NewEntry> batch;
+        batch.reserve(options_.maxBatch);
+        for (;;) {
+            std::uint64_t seen = signal_.load(std::memory_order_acquire);
+            batch.clear();
+            if (queue_.popBatch(batch, options_.maxBatch) == 0) {
+                if (stopping_.load(std::memory_order_acquire) && queue_.size() == 0) return;
+                signal_.wait(seen, std::memory_order_acquire);
+                continue;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            ledger_.addEntries(batch);
+            std::int64_t elapsed = std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count();
+
+            totalCommitNs_.fetch_add(elapsed, std::memory_order_relaxed);
+            if (elapsed > maxCommitNs_.load(std::memory_order_relaxed)) {
+                maxCommitNs_.store(elapsed, std::memory_order_relaxed);
+            }
+            batches_.fetch_add(1, std::memory_order_relaxed);
+            committed_.fetch_add(batch.size(), std::memory_order_release);
+            committed_.notify_all();
+        }
+    }
+
+public:
+    explicit IngestQueue(ConcurrentBudgetManager& ledger, IngestOptions options = {})
+        : ledger_(ledger), options_(options), queue_(options.capacity) {
+        options_.maxBatch = std::max<std::size_t>(options_.maxBatch, 1);
+        committer_ = std::thread([this] { commitLoop(); });
+    }
+
+    IngestQueue(const IngestQueue&) = delete;
+    IngestQueue& operator=(const IngestQueue&) = delete;
+
+    // Commits everything still queued, then stops the committer
+    ~IngestQueue() {
+        stopping_.store(true, std::memory_order_release);
+        signal_.fetch_add(1, std::memory_order_release);
+        signal_.notify_one();
+        committer_.join();
+    }
+
+    // Queues `entry` unless the queue is full; on failure `entry` is left intact
+    bool tryPush(NewEntry& entry) {
+        if (!queue_.tryPush(entry)) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        notePushed();
+        return true;
+    }
+
+    // Queues `entry`, waiting for the committer to make room if the queue is full
+    void push(NewEntry entry) {
+        bool waited = false;
+        for (;;) {
+            std::uint64_t committed = committed_.load(std::memory_order_acquire);
+            if (queue_.tryPush(entry)) break;
+            if (!waited) waits_.fetch_add(1, std::memory_order_relaxed);
+            waited = true;
+            committed_.wait(committed, std::memory_order_acquire);
+        }
+        notePushed();
+    }
+
+    // Waits until every entry queued before the call has been committed
+    void flush() {
+        std::uint64_t target = pushed_.load(std::memory_order_acquire);
+        for (;;) {
+            std::uint64_t committed = committed_.load(std::memory_order_acquire);
+            if (committed >= target) return;
+            committed_.wait(committed, std::memory_order_acquire);
+        }
+    }
+
+    IngestMetrics getMetrics() const {
+        IngestMetrics metrics;
+        metrics.committed = committed_.load(std::memory_order_acquire);
+        metrics.enqueued = pushed_.load(std::memory_order_acquire);
+        metrics.batches = batches_.load(std::memory_order_relaxed);
+        metrics.rejected = rejected_.load(std::memory_order_relaxed);
+        metrics.waits = waits_.load(std::memory_order_relaxed);
+        metrics.depth = queue_.size();
+        metrics.maxDepth = maxDepth_.load(std::memory_order_relaxed);
+        metrics.totalCommit = std::chrono::nanoseconds(totalCommitNs_.load(std::memory_order_relaxed));
+        metrics.maxCommit = std::chrono::nanoseconds(maxCommitNs_.load(std::memory_order_relaxed));
+        return metrics;
+    }
+};
+
+} // namespace budget
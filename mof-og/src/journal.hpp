@@ -0,0 +1,490 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "fileio.hpp"
+#include "manager.hpp"
+#include "mapped_file.hpp"
+#include "money.hpp"
+#include "snapshot.hpp"
+#include "store.hpp"
+
+namespace budget {
+
+struct JournalOptions {
+    std::size_t batchRecords = 32;          // records buffered before a write + fsync
+    std::size_t compactBytes = 16 << 20;    // journal size that triggers folding into the base
+};
+
+// Append-only write-ahead journal next to a base file ("<base>.journal").
+//
+// While attached to a BudgetManager, every mutation is encoded as a small
+// binary record and buffered; each batch is written and fsync'ed together, so
+// a crash loses at most the unsynced batch. Opening loads the base (CSV or
+// snapshot) and replays the journal on top of it. Once the journal grows past
+// JournalOptions::compactBytes it is folded into a fresh base and truncated.
+//
+// Record layout: u32 payload size | u64 checksum | payload, where the payload
+// starts with a RecordType byte. Replay stops at the first torn or corrupt
+// record and cuts the file there. Replay is idempotent (adds of an existing ID
+// replace it), so a crash between rewriting the base and truncating the
+// journal is harmless.
+class Journal : public BudgetListener {
+private:
+    static constexpr char MAGIC[8] = {'M', 'O', 'F', 'J', 'R', 'N', 'L', '\0'};
+    static constexpr std::uint32_t VERSION = 2; // 2: amounts in minor units
+    static constexpr std::size_t HEADER_SIZE = sizeof(MAGIC) + sizeof(std::uint32_t);
+    static constexpr std::size_t RECORD_HEADER_SIZE = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+
+    enum class RecordType : std::uint8_t {
+        ADD,
+        MODIFY,
+        REMOVE,
+        CLEAR,
+        SETTING,
+        RATE
+    };
+
+    BudgetManager* manager_ = nullptr;
+    JournalOptions options_;
+    std::string basePath_;
+    bool baseIsSnapshot_ = true;
+    std::FILE* file_ = nullptr;
+    std::string pending_;
+    std::size_t pendingRecords_ = 0;
+    std::size_t journalBytes_ = 0;
+    std::size_t replayedRecords_ = 0;
+    bool failed_ = false;
+
+    // Encoding
+
+    template <typename T>
+    static void put(std::string& out, T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    // Stops journaling after an I/O error, dropping what is buffered
+    bool fail() {
+        failed_ = true;
+        pending_.clear();
+        pendingRecords_ = 0;
+        return false;
+    }
+
+    void beginRecord(RecordType type) {
+        put(pending_, std::uint32_t{0}); // size and checksum patched in endRecord
+        put(pending_, std::uint64_t{0});
+        put(pending_, type);
+    }
+
+    void endRecord(std::size_t start) {
+        if (failed_) {
+            // Nothing is written after an I/O error, so don't let the buffer grow
+            pending_.resize(start);
+            return;
+        }
+        std::string_view payload = std::string_view(pending_).substr(start + RECORD_HEADER_SIZE);
+        SnapshotChecksum checksum;
+        checksum.update(payload);
+        auto size = static_cast<std::uint32_t>(payload.size());
+        std::uint64_t value = checksum.value();
+        std::memcpy(pending_.data() + start, &size, sizeof(size));
+        std::memcpy(pending_.data() + start + sizeof(size), &value, sizeof(value));
+
+        if (++pendingRecords_ >= options_.batchRecords) {
+            sync();
+        }
+    }
+
+    void putEntry(RecordType type, const EntryView& entry) {
+        std::size_t start = pending_.size();
+        beginRecord(type);
+        put(pending_, entry.getId());
+        put(pending_, entry.getAmount().getMinor());
+        put(pending_, entry.getCategory());
+        put(pending_, entry.getCurrency());
+        put(pending_, static_cast<std::int64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(entry.getTimestamp().time_since_epoch()).count()));
+        put(pending_, static_cast<std::uint32_t>(entry.getDescription().size()));
+        pending_.append(entry.getDescription());
+        endRecord(start);
+    }
+
+    // Decoding
+
+    class Reader {
+    private:
+        std::string_view bytes_;
+
+    public:
+        explicit Reader(std::string_view bytes) : bytes_(bytes) {}
+
+        template <typename T>
+        bool get(T& value) {
+            if (bytes_.size() < sizeof(T)) return false;
+            std::memcpy(&value, bytes_.data(), sizeof(T));
+            bytes_.remove_prefix(sizeof(T));
+            return true;
+        }
+
+        bool get(std::string_view& text, std::size_t size) {
+            if (bytes_.size() < size) return false;
+            text = bytes_.substr(0, size);
+            bytes_.remove_prefix(size);
+            return true;
+        }
+
+        bool done() const { return bytes_.empty(); }
+    };
+
+    static bool apply(BudgetManager& manager, std::string_view payload) {
+        Reader reader(payload);
+        RecordType type;
+        if (!reader.get(type)) return false;
+
+        switch (type) {
+            case RecordType::ADD:
+            case RecordType::MODIFY: {
+                EntryId id;
+                std::int64_t amount;
+                Category category;
+                Currency currency;
+                std::int64_t nanos;
+                std::uint32_t length;
+                std::string_view description;
+                if (!reader.get(id) || !reader.get(amount) || !reader.get(category) || !reader.get(currency) ||
+                    !reader.get(nanos) || !reader.get(length) || !reader.get(description, length) ||
+                    !reader.done() || static_cast<std::size_t>(category) >= CATEGORY_COUNT ||
+                    static_cast<std::size_t>(currency) >= CURRENCY_COUNT) {
+                    return false;
+                }
+                if (type == RecordType::MODIFY) {
+                    manager.modifyEntry(std::to_string(id), std::string(description), Money::fromMinor(amount),
+                                        category, currency);
+                    return true;
+                }
+                // An add of an ID that already exists can only come from replaying over a
+                // base that already contains it; replace the entry rather than duplicate it
+                manager.deleteEntry(std::to_string(id));
+                auto timestamp = std::chrono::system_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanos)));
+                manager.restoreEntry(id, description, Money::fromMinor(amount), category, currency, timestamp);
+                return true;
+            }
+            case RecordType::REMOVE: {
+                EntryId id;
+                if (!reader.get(id) || !reader.done()) return false;
+                manager.deleteEntry(std::to_string(id));
+                return true;
+            }
+            case RecordType::CLEAR:
+                manager.clear();
+                return reader.done();
+            case RecordType::SETTING: {
+                BudgetSetting setting;
+                double value;
+                if (!reader.get(setting) || !reader.get(value) || !reader.done()) return false;
+                applySetting(manager, setting, value);
+                return true;
+            }
+            case RecordType::RATE: {
+                Currency currency;
+                double rate;
+                if (!reader.get(currency) || !reader.get(rate) || !reader.done() ||
+                    static_cast<std::size_t>(currency) >= CURRENCY_COUNT) {
+                    return false;
+                }
+                if (currency != BASE_CURRENCY && rate > 0.0 && std::isfinite(rate)) manager.setRate(currency, rate);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void applySetting(BudgetManager& manager, BudgetSetting setting, double value) {
+        switch (setting) {
+            case BudgetSetting::EXCHANGE_RATE:
+                if (value > 0.0) manager.setExchangeRate(value);
+                break;
+            case BudgetSetting::BABU_INCOME:
+                if (value >= 0.0) manager.setBabuIncome(Money::fromMajor(value));
+                break;
+            case BudgetSetting::MAMU_INCOME:
+                if (value >= 0.0) manager.setMamuIncome(Money::fromMajor(value));
+                break;
+            case BudgetSetting::NEXT_ID:
+                manager.reserveIdsBelow(static_cast<EntryId>(value));
+                break;
+        }
+    }
+
+    // Replays the journal into the manager and sets `validBytes` to the length
+    // of its valid prefix, 0 if there is no journal yet. Returns false if the
+    // file exists but is not a journal this version can read; it is left as is,
+    // since starting afresh over it would throw its records away.
+    bool replay(const std::string& path, std::size_t& validBytes) {
+        validBytes = 0;
+        std::error_code error;
+        if (!std::filesystem::exists(path, error)) return !error;
+
+        MappedFile file;
+        if (!file.open(path)) return false;
+        std::string_view data = file.view();
+        std::uint32_t version = 0;
+        if (data.size() < HEADER_SIZE || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+        std::memcpy(&version, data.data() + sizeof(MAGIC), sizeof(version));
+        if (version != VERSION) return false;
+
+        std::size_t offset = HEADER_SIZE;
+        while (data.size() - offset >= RECORD_HEADER_SIZE) {
+            std::uint32_t size;
+            std::uint64_t expected;
+            std::memcpy(&size, data.data() + offset, sizeof(size));
+            std::memcpy(&expected, data.data() + offset + sizeof(size), sizeof(expected));
+            if (size > data.size() - offset - RECORD_HEADER_SIZE) break;
+
+            std::string_view payload = data.substr(offset + RECORD_HEADER_SIZE, size);
+            SnapshotChecksum checksum;
+            checksum.update(payload);
+            if (checksum.value() != expected || !apply(*manager_, payload)) break;
+
+            offset += RECORD_HEADER_SIZE + size;
+            ++replayedRecords_;
+        }
+        validBytes = offset;
+        return true;
+    }
+
+    static bool fsyncFile(std::FILE* file) {
+        if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return ::fsync(::fileno(file)) == 0;
+#endif
+    }
+
+    // Flushes a file written and closed elsewhere (e.g. by FileIO) to disk
+    static bool fsyncPath(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "rb+");
+        if (file == nullptr) return false;
+        bool synced = fsyncFile(file);
+        return std::fclose(file) == 0 && synced;
+    }
+
+    // Makes a rename inside `path`'s directory durable; Windows has no
+    // directory handle to flush, its metadata journal covers the rename
+    static bool fsyncParent(const std::string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        std::filesystem::path parent = std::filesystem::path(path).parent_path();
+        int fd = ::open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool synced = ::fsync(fd) == 0;
+        return ::close(fd) == 0 && synced;
+#endif
+    }
+
+    // Opens the journal for appending, starting a new one if `validBytes` is 0.
+    // A new journal is written beside the old one and renamed over it, so a
+    // crash never leaves a file too short to carry the header.
+    bool openForAppend(const std::string& path, std::size_t validBytes) {
+        std::error_code error;
+        if (validBytes == 0) {
+            std::string temporary = path + ".tmp";
+            std::FILE* fresh = std::fopen(temporary.c_str(), "wb");
+            if (fresh == nullptr) return false;
+            std::uint32_t version = VERSION;
+            bool written = std::fwrite(MAGIC, 1, sizeof(MAGIC), fresh) == sizeof(MAGIC) &&
+                           std::fwrite(&version, sizeof(version), 1, fresh) == 1 && fsyncFile(fresh);
+            if (std::fclose(fresh) != 0 || !written) return false;
+            std::filesystem::rename(temporary, path, error);
+            if (error || !fsyncParent(path)) return false;
+            validBytes = HEADER_SIZE;
+        }
+
+        // Drop a torn tail so new records follow the last good one
+        if (std::filesystem::file_size(path, error) != validBytes) {
+            std::filesystem::resize_file(path, validBytes, error);
+            if (error) return false;
+        }
+        file_ = std::fopen(path.c_str(), "ab");
+        journalBytes_ = validBytes;
+        return file_ != nullptr;
+    }
+
+    bool writeBase(const std::string& path) const {
+        return baseIsSnapshot_ ? FileIO::saveSnapshot(*manager_, path) : FileIO::saveBudget(*manager_, path);
+    }
+
+public:
+    Journal() = default;
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    ~Journal() {
+        close();
+    }
+
+    static std::string journalPath(const std::string& basePath) {
+        return basePath + ".journal";
+    }
+
+    // Loads `basePath` (if present) plus its journal into `manager`, then attaches
+    // to it so later mutations are journaled. A missing base starts empty and is
+    // created as a snapshot on the first compaction. Fails, leaving the journal
+    // untouched, if it is unreadable or from another journal version.
+    bool open(BudgetManager& manager, const std::string& basePath, const JournalOptions& options = {}) {
+        close();
+        manager_ = &manager;
+        options_ = options;
+        basePath_ = basePath;
+        replayedRecords_ = 0;
+        failed_ = false;
+
+        std::error_code error;
+        manager.clear();
+        if (std::filesystem::exists(basePath, error)) {
+            baseIsSnapshot_ = SnapshotView::isSnapshot(basePath);
+            if (!FileIO::loadAny(manager, basePath)) {
+                manager_ = nullptr;
+                return false;
+            }
+        } else {
+            baseIsSnapshot_ = true;
+        }
+
+        std::size_t validBytes = 0;
+        if (!replay(journalPath(basePath), validBytes) || !openForAppend(journalPath(basePath), validBytes)) {
+            manager_ = nullptr;
+            return false;
+        }
+        manager.setListener(this);
+        return true;
+    }
+
+    // Writes and fsyncs the buffered records; compacts if the journal has grown
+    // past the threshold. Returns false (and stays failed) on an I/O error.
+    bool sync() {
+        if (file_ == nullptr || failed_) return false;
+        if (!pending_.empty()) {
+            if (std::fwrite(pending_.data(), 1, pending_.size(), file_) != pending_.size() || !fsyncFile(file_)) {
+                return fail();
+            }
+            journalBytes_ += pending_.size();
+            pending_.clear();
+            pendingRecords_ = 0;
+        }
+        if (journalBytes_ >= options_.compactBytes) {
+            return compact();
+        }
+        return true;
+    }
+
+    // Folds the journal into a new base file, written beside the old one and
+    // renamed over it, then starts an empty journal. The new base and the
+    // rename are on disk before the journal is truncated, so a crash at any
+    // point leaves either the old base and its journal or the new base.
+    bool compact() {
+        if (file_ == nullptr || failed_) return false;
+        if (!pending_.empty()) {
+            // Everything pending is already in the manager and goes into the base
+            pending_.clear();
+            pendingRecords_ = 0;
+        }
+
+        std::string temporary = basePath_ + ".tmp";
+        std::error_code error;
+        if (!writeBase(temporary) || !fsyncPath(temporary)) {
+            return fail();
+        }
+        std::filesystem::rename(temporary, basePath_, error);
+        if (error || !fsyncParent(basePath_)) {
+            return fail();
+        }
+
+        std::fclose(file_);
+        file_ = nullptr;
+        if (!openForAppend(journalPath(basePath_), 0)) {
+            return fail();
+        }
+        return true;
+    }
+
+    // Syncs outstanding records and detaches from the manager
+    void close() {
+        if (manager_ == nullptr) return;
+        sync();
+        manager_->setListener(nullptr);
+        manager_ = nullptr;
+        if (file_ != nullptr) {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+
+    bool isOpen() const { return manager_ != nullptr; }
+    bool hasFailed() const { return failed_; }
+    std::size_t getPendingRecords() const { return pendingRecords_; }
+    std::size_t getJournalBytes() const { return journalBytes_; }
+    std::size_t getReplayedRecords() const { return replayedRecords_; }
+
+    void onAdd(const EntryView& entry) override {
+        putEntry(RecordType::ADD, entry);
+    }
+
+    void onModify(const EntryView& entry) override {
+        putEntry(RecordType::MODIFY, entry);
+    }
+
+    void onDelete(EntryId id) override {
+        std::size_t start = pending_.size();
+        beginRecord(RecordType::REMOVE);
+        put(pending_, id);
+        endRecord(start);
+    }
+
+    void onClear() override {
+        std::size_t start = pending_.size();
+        beginRecord(RecordType::CLEAR);
+        endRecord(start);
+    }
+
+    void onSetting(BudgetSetting setting, double value) override {
+        std::size_t start = pending_.size();
+        beginRecord(RecordType::SETTING);
+        put(pending_, setting);
+        put(pending_, value);
+        endRecord(start);
+    }
+
+    void onRate(Currency currency, double unitsPerBase) override {
+        std::size_t start = pending_.size();
+        beginRecord(RecordType::RATE);
+        put(pending_, currency);
+        put(pending_, unitsPerBase);
+        endRecord(start);
+    }
+};
+
+} // namespace budget
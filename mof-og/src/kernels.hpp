@@ -0,0 +1,208 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "money.hpp"
+#include "simd.hpp"
+
+namespace budget {
+
+using CategoryAmounts = std::array<std::array<Money, CURRENCY_COUNT>, CATEGORY_COUNT>;
+using CategoryCounts = std::array<std::array<std::size_t, CURRENCY_COUNT>, CATEGORY_COUNT>;
+
+// Column slices fed to the histogram kernel. A non-empty selection restricts the
+// pass to rows whose selection byte is non-zero. Rows whose category is outside
+// [0, CATEGORY_COUNT) (e.g. EntryStore tombstones) are ignored.
+struct HistogramInput {
+    std::span<const Money> amounts;
+    std::span<const Category> categories;
+    std::span<const Currency> currencies;
+    std::span<const std::uint8_t> selection = {};
+};
+
+// Single-pass per-(Category, Currency) totals and counts.
+//
+// Each row maps to a bin key = category * CURRENCY_COUNT + currency, with
+// tombstones and unselected rows sent to a trailing trash bin so the inner loop
+// has no branches. Keys are computed 16 (SSE4.1) or 32 (AVX2) rows at a time;
+// the amounts are then scattered into four interleaved partial tables so that
+// consecutive rows landing in the same bin do not serialize on one accumulator.
+// Amounts are integer minor units, so the result is exact and independent of
+// the instruction set or the order in which rows are summed.
+// The widest instruction set the CPU supports is picked once at runtime.
+class HistogramKernel {
+public:
+    using Fn = void (*)(const HistogramInput&, CategoryAmounts&, CategoryCounts&);
+
+    static void accumulate(const HistogramInput& input, CategoryAmounts& totals, CategoryCounts& counts) {
+        selected().fn(input, totals, counts);
+    }
+
+    static std::string_view getIsaName() {
+        return selected().name;
+    }
+
+    static void accumulateScalar(const HistogramInput& input, CategoryAmounts& totals,
+                                 CategoryCounts& counts) {
+        Bins bins{};
+        accumulateScalarRange(input, 0, input.amounts.size(), bins);
+        bins.reduceInto(totals, counts);
+    }
+
+#ifdef BUDGET_X86_SIMD
+    __attribute__((target("sse4.1")))
+    static void accumulateSse41(const HistogramInput& input, CategoryAmounts& totals,
+                                CategoryCounts& counts) {
+        constexpr std::size_t WIDTH = 16;
+        const std::size_t n = input.amounts.size();
+        const bool masked = !input.selection.empty();
+        const __m128i categoryLimit = _mm_set1_epi8(static_cast<char>(CATEGORY_COUNT));
+        const __m128i trash = _mm_set1_epi8(static_cast<char>(TRASH_KEY));
+        alignas(16) std::uint8_t keys[WIDTH];
+        Bins bins{};
+
+        std::size_t i = 0;
+        for (; i + WIDTH <= n; i += WIDTH) {
+            __m128i category = _mm_min_epu8(loadBytes128(input.categories.data() + i), categoryLimit);
+            __m128i key = loadBytes128(input.currencies.data() + i);
+            for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                key = _mm_add_epi8(key, category);
+            }
+            if (masked) {
+                __m128i selection = loadBytes128(input.selection.data() + i);
+                key = _mm_or_si128(key, _mm_cmpeq_epi8(selection, _mm_setzero_si128()));
+            }
+            _mm_store_si128(reinterpret_cast<__m128i*>(keys), _mm_min_epu8(key, trash));
+            bins.scatter(keys, input.amounts.data() + i, WIDTH);
+        }
+        accumulateScalarRange(input, i, n, bins);
+        bins.reduceInto(totals, counts);
+    }
+
+    __attribute__((target("avx2")))
+    static void accumulateAvx2(const HistogramInput& input, CategoryAmounts& totals,
+                               CategoryCounts& counts) {
+        constexpr std::size_t WIDTH = 32;
+        const std::size_t n = input.amounts.size();
+        const bool masked = !input.selection.empty();
+        const __m256i categoryLimit = _mm256_set1_epi8(static_cast<char>(CATEGORY_COUNT));
+        const __m256i trash = _mm256_set1_epi8(static_cast<char>(TRASH_KEY));
+        alignas(32) std::uint8_t keys[WIDTH];
+        Bins bins{};
+
+        std::size_t i = 0;
+        for (; i + WIDTH <= n; i += WIDTH) {
+            __m256i category = _mm256_min_epu8(loadBytes256(input.categories.data() + i), categoryLimit);
+            __m256i key = loadBytes256(input.currencies.data() + i);
+            for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                key = _mm256_add_epi8(key, category);
+            }
+            if (masked) {
+                __m256i selection = loadBytes256(input.selection.data() + i);
+                key = _mm256_or_si256(key, _mm256_cmpeq_epi8(selection, _mm256_setzero_si256()));
+            }
+            _mm256_store_si256(reinterpret_cast<__m256i*>(keys), _mm256_min_epu8(key, trash));
+            bins.scatter(keys, input.amounts.data() + i, WIDTH);
+        }
+        accumulateScalarRange(input, i, n, bins);
+        bins.reduceInto(totals, counts);
+    }
+#endif
+
+private:
+    static constexpr std::size_t TRASH_KEY = CATEGORY_COUNT * CURRENCY_COUNT;
+    static constexpr std::size_t BIN_COUNT = TRASH_KEY + 1;
+    static_assert(BIN_COUNT + CURRENCY_COUNT <= 256, "bin keys must fit in one byte");
+
+    struct Bins {
+        std::int64_t sums[4][BIN_COUNT];
+        std::uint64_t counts[4][BIN_COUNT];
+
+        // `count` must be a multiple of 4
+        void scatter(const std::uint8_t* keys, const Money* amounts, std::size_t count) {
+            for (std::size_t j = 0; j < count; j += 4) {
+                sums[0][keys[j]] += amounts[j].getMinor();
+                sums[1][keys[j + 1]] += amounts[j + 1].getMinor();
+                sums[2][keys[j + 2]] += amounts[j + 2].getMinor();
+                sums[3][keys[j + 3]] += amounts[j + 3].getMinor();
+                ++counts[0][keys[j]];
+                ++counts[1][keys[j + 1]];
+                ++counts[2][keys[j + 2]];
+                ++counts[3][keys[j + 3]];
+            }
+        }
+
+        void reduceInto(CategoryAmounts& totals, CategoryCounts& binCounts) const {
+            for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+                for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                    std::size_t key = c * CURRENCY_COUNT + k;
+                    totals[c][k] += Money::fromMinor(sums[0][key] + sums[1][key] + sums[2][key] + sums[3][key]);
+                    binCounts[c][k] += counts[0][key] + counts[1][key] + counts[2][key] + counts[3][key];
+                }
+            }
+        }
+    };
+
+    struct Selection {
+        Fn fn;
+        std::string_view name;
+    };
+
+    static const Selection& selected() {
+        static const Selection selection = detect();
+        return selection;
+    }
+
+    static Selection detect() {
+#ifdef BUDGET_X86_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return {&accumulateAvx2, "avx2"};
+        if (__builtin_cpu_supports("sse4.1")) return {&accumulateSse41, "sse4.1"};
+#endif
+        return {&accumulateScalar, "scalar"};
+    }
+
+    static std::uint8_t keyOf(const HistogramInput& input, std::size_t row) {
+        std::size_t category = std::min(static_cast<std::size_t>(input.categories[row]), CATEGORY_COUNT);
+        std::size_t key = category * CURRENCY_COUNT + static_cast<std::size_t>(input.currencies[row]);
+        if (!input.selection.empty() && input.selection[row] == 0) key = TRASH_KEY;
+        return static_cast<std::uint8_t>(std::min(key, TRASH_KEY));
+    }
+
+    static void accumulateScalarRange(const HistogramInput& input, std::size_t begin, std::size_t end,
+                                      Bins& bins) {
+        std::uint8_t keys[4];
+        std::size_t i = begin;
+        for (; i + 4 <= end; i += 4) {
+            for (std::size_t j = 0; j < 4; ++j) keys[j] = keyOf(input, i + j);
+            bins.scatter(keys, input.amounts.data() + i, 4);
+        }
+        for (; i < end; ++i) {
+            std::uint8_t key = keyOf(input, i);
+            bins.sums[0][key] += input.amounts[i].getMinor();
+            ++bins.counts[0][key];
+        }
+    }
+
+#ifdef BUDGET_X86_SIMD
+    template <typename T>
+    static __m128i loadBytes128(const T* bytes) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+    }
+
+    template <typename T>
+    __attribute__((target("avx2")))
+    static __m256i loadBytes256(const T* bytes) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+    }
+#endif
+};
+
+} // namespace budget
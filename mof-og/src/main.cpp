@@ -1,14 +1,29 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <format>
+#include <fstream>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <print>
+#include <span>
 #include <string>
-#include <thread>
+#include <string_view>
+#include <vector>
 
+#include "batch.hpp"
 #include "category.hpp"
 #include "currency.hpp"
 #include "fileio.hpp"
+#include "journal.hpp"
 #include "manager.hpp"
+#include "pager.hpp"
+#include "query.hpp"
+#include "timestamp.hpp"
 
 using namespace budget;
 
@@ -23,6 +38,9 @@ void displayMenu() {
   std::print("7. Save Budget to File\n");
   std::print("8. Set Income\n");
   std::print("9. Set Exchange Rate\n");
+  std::print("10. View Spending by Month\n");
+  std::print("11. Revalue at Historical Rates\n");
+  std::print("12. View Largest Spends\n");
   std::print("0. Exit\n");
   std::print("===============================================\n");
   std::print("Enter your choice: ");
@@ -51,14 +69,18 @@ Category selectCategory() {
 
 Currency selectCurrency() {
   std::print("\nAvailable Currencies:\n");
-  std::print("1. GBP (£)\n");
-  std::print("2. USD ($)\n");
-  std::print("Select currency (1-2): ");
+  auto currencies = CurrencyConverter::getAllCurrencies();
+  for (size_t i = 0; i < currencies.size(); ++i) {
+    std::print("{}. {} ({})\n", i + 1, CurrencyConverter::toString(currencies[i]),
+               CurrencyConverter::getSymbol(currencies[i]));
+  }
+  std::print("Select currency (1-{}): ", currencies.size());
   int choice;
   std::cin >> choice;
 
-  if (choice == 1) return Currency::GBP;
-  if (choice == 2) return Currency::USD;
+  if (choice >= 1 && choice <= static_cast<int>(currencies.size())) {
+    return currencies[choice - 1];
+  }
   throw std::invalid_argument("Invalid currency selection");
 }
 
@@ -87,18 +109,14 @@ void addEntry(BudgetManager& manager) {
       return;
     }
 
-    std::string description = CategoryManager::toString(category);
+    std::string description(CategoryManager::toString(category));
     std::ranges::transform(description, description.begin(), [](unsigned char c) { return std::tolower(c); });
     description = std::format("{}_{:.2f}_{}", description, amount,
                              CurrencyConverter::toString(currency));
 
-    amount = CurrencyConverter::convert(amount, manager.getExchangeRate(), currency,
-                                        Currency::GBP);  // Ensure amount is in selected currency
-
-    std::string id = manager.addEntry(description, amount, category, Currency::GBP);
+    // Kept in the currency it was paid in; reports convert at the rates of the day
+    std::string id = manager.addEntry(description, Money::fromMajor(amount), category, currency);
     std::print("\033[32m\n✓ Entry added successfully with ID: {}\033[0m\n", id);
-
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
   }
 }
 
@@ -121,10 +139,7 @@ void modifyEntry(BudgetManager& manager) {
   Category category = selectCategory();
   Currency currency = selectCurrency();
 
-  amount = CurrencyConverter::convert(amount, manager.getExchangeRate(), currency,
-                                      Currency::GBP);  // Ensure amount is in selected currency
-
-  if (manager.modifyEntry(id, description, amount, category, Currency::GBP)) {
+  if (manager.modifyEntry(id, description, Money::fromMajor(amount), category, currency)) {
     std::print("\033[32m\n✓ Entry modified successfully\033[0m\n");
   } else {
     std::print("\033[31m\n✗ Entry not found\033[0m\n");
@@ -146,7 +161,25 @@ void deleteEntry(BudgetManager& manager) {
   }
 }
 
+// Terminal size and colour, read once per view; COLUMNS and LINES are set by
+// most shells, NO_COLOR turns the emphasis off
+PagerOptions terminalOptions() {
+  PagerOptions options;
+  auto number = [](const char* name, size_t fallback) {
+    const char* text = std::getenv(name);
+    size_t value = 0;
+    if (!text) return fallback;
+    auto [ptr, ec] = std::from_chars(text, text + std::strlen(text), value);
+    return ec == std::errc{} && *ptr == '\0' && value > 0 ? value : fallback;
+  };
+  options.width = number("COLUMNS", options.width);
+  options.pageSize = std::max<size_t>(number("LINES", options.pageSize + 5), 10) - 5; // header, footer, prompt
+  options.colour = std::getenv("NO_COLOR") == nullptr;
+  return options;
+}
+
 void viewAllEntries(const BudgetManager& manager) {
+  std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
   std::print("\n--- All Budget Entries ---\n");
 
   if (manager.getEntryCount() == 0) {
@@ -154,42 +187,200 @@ void viewAllEntries(const BudgetManager& manager) {
     return;
   }
 
-  std::print("{:<12}{:<20}{:>10}  {:<15}{:<10}\n", "ID", "Description", "Amount", "Category", "Currency");
-  std::print("{}\n", std::string(77, '-'));
+  EntryPager pager(manager, terminalOptions());
+  TimestampParser dates;
+  for (;;) {
+    std::string_view page = pager.page();
+    std::fwrite(page.data(), 1, page.size(), stdout);
+    std::print("[Enter/n]ext [p]revious [f]irst [l]ast, #<id> or YYYY-MM-DD to jump, [q]uit: ");
+
+    std::string input;
+    if (!std::getline(std::cin, input) || input == "q") return;
+    if (input.empty() || input == "n") {
+      if (!pager.next()) {
+        if (input.empty()) return;
+        std::print("\033[31m✗ Already on the last page\033[0m\n");
+      }
+    } else if (input == "p") {
+      if (!pager.previous()) std::print("\033[31m✗ Already on the first page\033[0m\n");
+    } else if (input == "f") {
+      pager.first();
+    } else if (input == "l") {
+      pager.last();
+    } else if (input.starts_with('#')) {
+      EntryId id = 0;
+      auto [ptr, ec] = std::from_chars(input.data() + 1, input.data() + input.size(), id);
+      if (ec != std::errc{} || ptr != input.data() + input.size() || !pager.jumpToId(id)) {
+        std::print("\033[31m✗ No entry with ID {}\033[0m\n", input.substr(1));
+      }
+    } else if (auto when = dates.parse(input + " 00:00:00")) {
+      if (!pager.jumpToDate(*when)) std::print("\033[31m✗ No entries on or after {}\033[0m\n", input);
+    } else {
+      std::print("\033[31m✗ Unknown command\033[0m\n");
+    }
+  }
+}
+
+// The biggest entries of a month (or of all time), in the base currency
+void viewLargestSpends(const BudgetManager& manager) {
+  std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+  std::print("\n--- Largest Spends ---\n");
+  std::print("Enter month (YYYY-MM, blank for all entries): ");
+  std::string input;
+  std::getline(std::cin, input);
+  std::optional<std::chrono::year_month> month;
+  if (!input.empty() && !(month = BatchRunner::parseMonth(input))) {
+    std::print("\033[31m\n✗ Invalid month. Use the form 2024-03.\033[0m\n");
+    return;
+  }
+  std::print("How many (default 20): ");
+  std::getline(std::cin, input);
+  size_t count = 20;
+  if (!input.empty()) {
+    auto [ptr, ec] = std::from_chars(input.data(), input.data() + input.size(), count);
+    if (ec != std::errc{} || ptr != input.data() + input.size()) {
+      std::print("\033[31m\n✗ Invalid count.\033[0m\n");
+      return;
+    }
+  }
+
+  Query query(manager);
+  if (month) query.onDates(*month / 1, *month / std::chrono::last);
+  auto largest = query.top(count);
+  if (largest.empty()) {
+    std::print("\nNo entries found.\n");
+    return;
+  }
 
-  for (const auto& entry : manager.getEntries()) {
-    std::print("{:<12}{:<20}{:>10.2f}  {:<14} {:<10}\n", entry->getId(), entry->getDescription().substr(0, 18),
-               entry->getAmount(), CategoryManager::toString(entry->getCategory()),
-               CurrencyConverter::toString(entry->getCurrency()));
+  std::print("\n{:<12}{:<20}{:>10}  {:<15}{:<10}{:>12}\n", "ID", "Description", "Amount", "Category", "Currency",
+             CurrencyConverter::toString(BASE_CURRENCY));
+  std::print("{}\n", std::string(89, '-'));
+  for (const auto& entry : largest) {
+    Money base = manager.getRates().convert(entry.getAmount(), entry.getCurrency(), BASE_CURRENCY);
+    std::print("{:<12}{:<20}{:>10.2f}  {:<14} {:<10}{:>12.2f}\n", entry.getId(), entry.getDescription().substr(0, 18),
+               entry.getAmount().toDouble(), CategoryManager::toString(entry.getCategory()),
+               CurrencyConverter::toString(entry.getCurrency()), base.toDouble());
   }
 }
 
-void viewCategorySummary(const BudgetManager& manager) {
-  std::print("\n--- Category Summary ---\n");
-  Currency currency = Currency::GBP;
+// Entries in every currency, converted into `currency`; incomes are in the base currency
+void printCategorySummary(const CategoryTotals& totals, Money grossIncome, const CurrencyRates& rates,
+                          Currency currency) {
+  double income = rates.convert(grossIncome, BASE_CURRENCY, currency).toDouble();
+  auto converted = totals.getTotalsIn(rates, currency);
 
   std::print("\nSummary for {}:\n", CurrencyConverter::toString(currency));
   std::print("{:<20}{:>15}  {:>11}\n", "Category", "Total", "Percentage");
   std::print("{}\n", std::string(48, '-'));
 
-  double grandTotal = 0.0;
+  Money spent;
   for (auto category : CategoryManager::getAllCategories()) {
-    double total = manager.getTotalByCategory(category, currency);
-    if (total > 0.0) {
+    Money total = converted[static_cast<size_t>(category)];
+    if (total > Money{}) {
       std::print("{:<20}{}{:>14.2f} {:>10.2f} %\n", CategoryManager::toString(category),
-                 CurrencyConverter::getSymbol(currency), total, (total / manager.getIncome()) * 100);
-      grandTotal += total;
+                 CurrencyConverter::getSymbol(currency), total.toDouble(), (total.toDouble() / income) * 100);
+      spent += total;
     }
   }
+  double grandTotal = spent.toDouble();
 
   std::print("{}\n", std::string(48, '-'));
-  std::print("{:<20}{}{:>14.2f}\n", "Gross Income", CurrencyConverter::getSymbol(currency), manager.getIncome());
+  std::print("{:<20}{}{:>14.2f}\n", "Gross Income", CurrencyConverter::getSymbol(currency), income);
   std::print("\033[31m{:<20}{}{:>14.2f} {:>10.2f} %\033[0m\n", "Grand Total", CurrencyConverter::getSymbol(currency),
-             grandTotal, (grandTotal / manager.getIncome()) * 100);
+             grandTotal, (grandTotal / income) * 100);
   std::print("\033[32m{:<20}{}{:>14.2f} {:>10.2f} %\033[0m\n", "Savings", CurrencyConverter::getSymbol(currency),
-             manager.getIncome() - grandTotal, ((manager.getIncome() - grandTotal) / manager.getIncome()) * 100);
+             income - grandTotal, ((income - grandTotal) / income) * 100);
+}
+
+void viewCategorySummary(const BudgetManager& manager) {
+  std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+  std::print("\n--- Category Summary ---\n");
+  std::print("Enter month (YYYY-MM, blank for all entries): ");
+  std::string input;
+  std::getline(std::cin, input);
+
+  // Incomes are monthly, so a single month compares like with like
+  std::optional<std::chrono::year_month> month;
+  if (!input.empty() && !(month = BatchRunner::parseMonth(input))) {
+    std::print("\033[31m\n✗ Invalid month. Use the form 2024-03.\033[0m\n");
+    return;
+  }
+
+  std::print("\nReport in which currency?");
+  Currency currency = selectCurrency();
+  if (!month) {
+    printCategorySummary(manager.getCategoryTotals(), manager.getIncome(), manager.getRates(), currency);
+    return;
+  }
+  std::print("\nMonth: {}-{:02}\n", static_cast<int>(month->year()), static_cast<unsigned>(month->month()));
+  printCategorySummary(manager.getTotalsForMonth(*month), manager.getIncome(), manager.getRates(), currency);
+}
+
+void viewMonthlySpending(const BudgetManager& manager) {
+  Currency currency = BASE_CURRENCY;
+  double income = manager.getIncome().toDouble();
+
+  std::print("\n--- Spending by Month ({}) ---\n", CurrencyConverter::toString(currency));
+  std::print("{:<10}{:>15}  {:>11}{:>15}\n", "Month", "Spent", "Of income", "Saved");
+  std::print("{}\n", std::string(53, '-'));
+
+  for (const auto& [month, totals] : manager.getMonthlyTotals()) {
+    Money total;
+    for (Money amount : totals.getTotalsIn(manager.getRates(), currency)) {
+      total += amount;
+    }
+    double spent = total.toDouble();
+    std::print("{}-{:02}   {}{:>14.2f} {:>10.2f} %{}{:>14.2f}\n", static_cast<int>(month.year()),
+               static_cast<unsigned>(month.month()), CurrencyConverter::getSymbol(currency), spent,
+               spent / income * 100, CurrencyConverter::getSymbol(currency), income - spent);
+  }
+}
+
+// Totals with every entry converted at the rates of its own day, from a file of
+// "YYYY-MM-DD,<currency>,<units per GBP>" lines (loaded once, then reused)
+void revalueAtHistoricalRates(const BudgetManager& manager, RateHistory& history) {
+  std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+  std::print("\n--- Revalue at Historical Rates ---\n");
+  std::print("Enter rates file ({}default: rates.csv): ", history.empty() ? "" : "blank to keep loaded rates, ");
+  std::string filename;
+  std::getline(std::cin, filename);
+
+  if (!filename.empty() || history.empty()) {
+    if (filename.empty()) filename = "rates.csv";
+    history.clear();
+    if (!history.load("data/" + filename)) {
+      std::print("\033[31m\n✗ Failed to read data/{}\033[0m\n", filename);
+      return;
+    }
+    std::print("Loaded {} dated rates from data/{}.\n", history.size(), filename);
+  }
+
+  Currency currency = selectCurrency();
+  auto start = std::chrono::steady_clock::now();
+  auto totals = manager.getTotalsAtHistoricalRates(history, currency);
+  std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::print("\n{:<20}{:>15}\n", "Category", "Total");
+  std::print("{}\n", std::string(35, '-'));
+  Money spent;
+  for (auto category : CategoryManager::getAllCategories()) {
+    Money total = totals[static_cast<size_t>(category)];
+    if (total != Money{}) {
+      std::print("{:<20}{}{:>14.2f}\n", CategoryManager::toString(category), CurrencyConverter::getSymbol(currency),
+                 total.toDouble());
+      spent += total;
+    }
+  }
+  std::print("{}\n", std::string(35, '-'));
+  std::print("{:<20}{}{:>14.2f}\n", "Grand Total", CurrencyConverter::getSymbol(currency), spent.toDouble());
+  std::print("Revalued {} entries in {:.1f} ms.\n", manager.getEntryCount(), elapsed.count());
 }
 
+constexpr std::string_view SNAPSHOT_EXTENSION = ".mofsnap";
+
 void loadBudget(BudgetManager& manager) {
   std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
@@ -202,9 +393,13 @@ void loadBudget(BudgetManager& manager) {
     filename = std::string{"budget.csv"};
   }
 
-  if (FileIO::loadBudget(manager, "data/" + filename)) {
+  LoadStats stats;
+  if (FileIO::loadAny(manager, "data/" + filename, LoadOptions{.threads = 0, .stats = &stats})) {
     std::print("\033[32m\n✓ Budget loaded successfully from data/{}\033[0m\n", filename);
-    std::print("Loaded {} entries.\n", manager.getEntryCount());
+    if (stats.bytes > 0) {
+      std::print("Loaded {} entries in {:.3f}s ({:.1f} MB/s, {} threads).\n", manager.getEntryCount(),
+                 stats.seconds, stats.getMegabytesPerSecond(), stats.threads);
+    }
   } else {
     std::print("\033[31m\n✗ Failed to load budget from data/{}\033[0m\n", filename);
   }
@@ -222,7 +417,10 @@ void saveBudget(const BudgetManager& manager) {
     filename = std::string{"budget.csv"};
   }
 
-  if (FileIO::saveBudget(manager, "data/" + filename)) {
+  // Files named *.mofsnap are written as binary snapshots, everything else as CSV
+  bool saved = filename.ends_with(SNAPSHOT_EXTENSION) ? FileIO::saveSnapshot(manager, "data/" + filename)
+                                                      : FileIO::saveBudget(manager, "data/" + filename);
+  if (saved) {
     std::print("\033[32m\n✓ Budget saved successfully to data/{}\033[0m\n", filename);
   } else {
     std::print("\033[31m\n✗ Failed to save budget to data/{}\033[0m\n", filename);
@@ -231,9 +429,9 @@ void saveBudget(const BudgetManager& manager) {
 
 void setIncome(BudgetManager& manager) {
   std::print("\n--- Set Income ---\n");
-  std::print("Current Babu income (GBP): {:.2f}\n", manager.getBabuIncome());
-  std::print("Current Mamu income (GBP): {:.2f}\n", manager.getMamuIncome());
-  std::print("Current Gross income (GBP): {:.2f}\n", manager.getIncome());
+  std::print("Current Babu income (GBP): {}\n", manager.getBabuIncome().toString());
+  std::print("Current Mamu income (GBP): {}\n", manager.getMamuIncome().toString());
+  std::print("Current Gross income (GBP): {}\n", manager.getIncome().toString());
   std::print("Enter Babu's monthly income (GBP): ");
   double babuIncome;
   std::cin >> babuIncome;
@@ -256,8 +454,8 @@ void setIncome(BudgetManager& manager) {
   }
 
   try {
-    manager.setBabuIncome(babuIncome);
-    manager.setMamuIncome(mamuIncome);
+    manager.setBabuIncome(Money::fromMajor(babuIncome));
+    manager.setMamuIncome(Money::fromMajor(mamuIncome));
     std::print("\033[32m✓ Incomes updated successfully.\033[0m\n");
   } catch (const std::exception& e) {
     std::print("\033[31mError: {}\033[0m\n", e.what());
@@ -265,21 +463,148 @@ void setIncome(BudgetManager& manager) {
 }
 
 void setExchangeRate(BudgetManager& manager) {
+  std::string_view base = CurrencyConverter::toString(BASE_CURRENCY);
   std::print("\n--- Set Exchange Rate ---\n");
-  std::print("Current exchange rate (GBP to USD): {:.2f}\n", manager.getExchangeRate());
-  std::print("Enter new exchange rate (GBP to USD): ");
+  std::print("Current rates (units per 1 {}):\n", base);
+  for (auto currency : CurrencyConverter::getAllCurrencies()) {
+    if (currency == BASE_CURRENCY) continue;
+    std::print("  {} {:.4f}\n", CurrencyConverter::toString(currency), manager.getRate(currency));
+  }
+  Currency currency = selectCurrency();
+  std::print("Enter new exchange rate ({} to {}): ", base, CurrencyConverter::toString(currency));
   double newRate;
   std::cin >> newRate;
   try {
-    manager.setExchangeRate(newRate);
+    manager.setRate(currency, newRate);
     std::print("\033[32mExchange rate updated successfully.\033[0m\n");
   } catch (const std::exception& e) {
     std::print("\033[31mError: {}\033[0m\n", e.what());
   }
 }
 
-int main() {
+// mof convert <input> <output>: CSV to snapshot, or snapshot back to CSV
+int convertBudget(const std::string& input, const std::string& output) {
+  BudgetManager manager;
+  bool fromSnapshot = SnapshotView::isSnapshot(input);
+  if (!FileIO::loadAny(manager, input, LoadOptions{.threads = 0})) {
+    std::print(stderr, "✗ Failed to load {}\n", input);
+    return 1;
+  }
+
+  bool saved = fromSnapshot ? FileIO::saveBudget(manager, output) : FileIO::saveSnapshot(manager, output);
+  if (!saved) {
+    std::print(stderr, "✗ Failed to write {}\n", output);
+    return 1;
+  }
+  std::print("✓ Converted {} entries from {} to {} ({})\n", manager.getEntryCount(), input, output,
+             fromSnapshot ? "CSV" : "snapshot");
+  return 0;
+}
+
+// mof summarize <file>...: one summary over all files, streamed without loading them
+int summarizeBudgets(std::span<const std::string> files, Currency currency) {
+  BudgetSummary summary;
+  if (!FileIO::summarize(files, summary)) {
+    std::print(stderr, "✗ Failed to read one of the files\n");
+    return 1;
+  }
+  std::print("\n--- Category Summary ({} files, {} entries) ---\n", summary.files, summary.entries);
+  printCategorySummary(summary.totals, summary.getIncome(), summary.rates, currency);
+  return 0;
+}
+
+// mof batch [<file>|-], or mof <command> [args...] [+ <command> [args...]]...:
+// runs commands without prompts, writing one JSON line per command to stdout
+int runBatch(BudgetManager& manager, Journal& journal, std::span<char*> args) {
+  std::ios::sync_with_stdio(false);
+  BatchRunner runner(manager, std::cout);
+
+  if (std::string_view(args[0]) == "batch") {
+    if (args.size() == 1 || std::string_view(args[1]) == "-") {
+      runner.run(std::cin);
+    } else {
+      std::ifstream commands(args[1]);
+      if (!commands) {
+        std::print(stderr, "✗ Failed to open {}\n", args[1]);
+        return 1;
+      }
+      runner.run(commands);
+    }
+  } else {
+    std::vector<std::string> words;
+    for (std::string_view arg : args) {
+      if (arg == "+") {
+        runner.run(words);
+        words.clear();
+      } else {
+        words.emplace_back(arg);
+      }
+    }
+    runner.run(words);
+  }
+
+  // One fsync for the whole run
+  if (journal.isOpen() && !journal.sync()) {
+    std::print(stderr, "✗ Failed to write the journal\n");
+    return 1;
+  }
+  runner.finish();
+  return runner.getFailedCount() == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
   BudgetManager manager;
+  Journal journal;
+  RateHistory history;
+
+  if (argc > 1) {
+    std::string_view command = argv[1];
+    if (command == "convert" && argc == 4) {
+      return convertBudget(argv[2], argv[3]);
+    }
+    if (command == "summarize" && argc >= 3) {
+      // An optional "--in <code>" picks the reporting currency
+      int first = 2;
+      Currency currency = BASE_CURRENCY;
+      if (std::string_view(argv[2]) == "--in" && argc >= 5) {
+        auto chosen = CurrencyConverter::tryFromString(argv[3]);
+        if (!chosen) {
+          std::print(stderr, "✗ Unknown currency {}\n", argv[3]);
+          return 2;
+        }
+        currency = *chosen;
+        first = 4;
+      }
+      std::vector<std::string> files(argv + first, argv + argc);
+      return summarizeBudgets(files, currency);
+    }
+    int first = 1;
+    if (command == "journal" && argc >= 3) {
+      // Every change is journaled next to the base file and survives a crash
+      if (!journal.open(manager, argv[2])) {
+        std::print(stderr, "✗ Failed to open journal for {} (a journal from another version is left untouched)\n",
+                   argv[2]);
+        return 1;
+      }
+      first = 3;
+    }
+    if (argc > first) {
+      std::string_view next = argv[first];
+      if (next != "batch" && !BatchRunner::isCommand(next)) {
+        std::print(stderr,
+                   "Usage: {0} [convert <input> <output> | summarize [--in <currency>] <file>...]\n"
+                   "       {0} [journal <base file>] [batch [<file>|-] | <command> [args...] [+ <command> ...]]\n",
+                   argv[0]);
+        return 2;
+      }
+      return runBatch(manager, journal, std::span<char*>(argv + first, argv + argc));
+    }
+    std::print("Journaling to {} ({} entries, {} records replayed).\n", Journal::journalPath(argv[2]),
+               manager.getEntryCount(), journal.getReplayedRecords());
+  }
+
+  // Largest-first queries walk these instead of scanning the ledger
+  manager.enableSortedViews();
 
   std::print("Welcome to Ministry of Finance Budget Tracker!\n");
   std::print("Manage your family budget with ease.\n");
@@ -326,6 +651,15 @@ int main() {
         case 9:
           setExchangeRate(manager);
           break;
+        case 10:
+          viewMonthlySpending(manager);
+          break;
+        case 11:
+          revalueAtHistoricalRates(manager, history);
+          break;
+        case 12:
+          viewLargestSpends(manager);
+          break;
         case 0:
           std::print("\nThank you for using Ministry of Finance Budget Tracker!\n");
           running = false;
@@ -339,7 +673,10 @@ int main() {
       std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     }
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    // One fsync per menu action, covering every change the action made
+    if (journal.isOpen() && !journal.sync()) {
+      std::print("\033[31m\n✗ Failed to write the journal; changes are no longer being saved\033[0m\n");
+    }
   }
 
   return 0;
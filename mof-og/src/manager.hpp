@@ -1,131 +1,519 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
 #include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <span>
 #include <stdexcept>
 
-#include "entry.hpp"
+#include "store.hpp"
+#include "time_index.hpp"
+#include "timestamp.hpp"
+#include "totals.hpp"
 #include "category.hpp"
 #include "currency.hpp"
+#include "money.hpp"
+#include "rate_history.hpp"
+#include "sorted_view.hpp"
 
 namespace budget {
 
+enum class BudgetSetting : std::uint8_t {
+    EXCHANGE_RATE, // GBP to USD; only in older journals, rates now go through onRate
+    BABU_INCOME,
+    MAMU_INCOME,
+    NEXT_ID
+};
+
+// An entry not yet in the ledger, e.g. parsed by an importer (see IngestQueue)
+struct NewEntry {
+    std::string description;
+    Money amount;
+    Category category = Category::OTHER;
+    Currency currency = BASE_CURRENCY;
+    std::chrono::system_clock::time_point timestamp = std::chrono::system_clock::now();
+};
+
+// The editable fields of an entry, as handed to BudgetManager::modifyWhere.
+// `description` starts out viewing the stored one; anything assigned to it must
+// stay alive until modifyWhere returns.
+struct EntryChange {
+    std::string_view description;
+    Money amount;
+    Category category;
+    Currency currency;
+
+    bool operator==(const EntryChange&) const = default;
+};
+
+// Told about every successful mutation of a BudgetManager, after it has been
+// applied (e.g. by Journal, which appends each one to a log)
+class BudgetListener {
+public:
+    virtual ~BudgetListener() = default;
+    virtual void onAdd(const EntryView& entry) = 0;
+    virtual void onModify(const EntryView& entry) = 0;
+    virtual void onDelete(EntryId id) = 0;
+    virtual void onClear() = 0;
+    // Rates and IDs as is, incomes in major units
+    virtual void onSetting(BudgetSetting setting, double value) = 0;
+    // Units of `currency` per one BASE_CURRENCY
+    virtual void onRate(Currency currency, double unitsPerBase) = 0;
+};
+
 class BudgetManager {
 private:
-    std::vector<std::unique_ptr<BudgetEntry>> entries_;
-    double exchangeRate_ = 1.38; // Default exchange rate GBP to USD
-    double babu_income_ = 4500.0; // Monthly income of Babu in GBP
-    double mamu_income_ = 3200.0; // Monthly income of Mamu in GBP
-    int nextId_ = 1;
+    EntryStore entries_;
+    CategoryTotals totals_;
+    CurrencyRates rates_;
+    Money babu_income_ = Money::fromMinor(450000); // Monthly income of Babu in GBP
+    Money mamu_income_ = Money::fromMinor(320000); // Monthly income of Mamu in GBP
+    EntryId nextId_ = 1;
+    BudgetListener* listener_ = nullptr;
+
+    // Built on the first time-based query, then kept in step with every mutation
+    mutable TimeIndex timeIndex_;
+    mutable TimestampFormatter localDays_;
+    mutable bool timeIndexReady_ = false;
+
+    // Orderings by amount and by time, once enableSortedViews has been called:
+    // built on the first ordered query, then kept in step with every mutation
+    mutable std::array<SortedView, SORT_KEY_COUNT> sortedViews_;
+    bool sortedViewsEnabled_ = false;
+    mutable bool sortedViewsReady_ = false;
+
+    // Returns the row holding the entry with the given ID, or EntryStore::NPOS if absent
+    size_t findRow(const std::string& id) const {
+        EntryId numericId = 0;
+        auto [ptr, ec] = std::from_chars(id.data(), id.data() + id.size(), numericId);
+        if (ec != std::errc{} || ptr != id.data() + id.size()) {
+            return EntryStore::NPOS;
+        }
+        return entries_.find(numericId);
+    }
+
+    const TimeIndex& timeIndex() const {
+        if (!timeIndexReady_) {
+            timeIndex_.clear();
+            for (const auto& entry : entries_) {
+                timeIndex_.add(localDays_.localDay(entry.getTimestamp()), entry.getCategory(),
+                               entry.getCurrency(), entry.getAmount());
+            }
+            timeIndexReady_ = true;
+        }
+        return timeIndex_;
+    }
+
+    std::int64_t sortKey(SortKey key, Money amount, Currency currency,
+                         std::chrono::system_clock::time_point timestamp) const {
+        if (key == SortKey::TIMESTAMP) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+        }
+        return rates_.convert(amount, currency, BASE_CURRENCY).getMinor();
+    }
+
+    SortedView::Item sortItem(SortKey key, const EntryView& entry) const {
+        return {sortKey(key, entry.getAmount(), entry.getCurrency(), entry.getTimestamp()), entry.getId()};
+    }
+
+    // Adds `entry` to, or removes it from, the sorted views; a modification only
+    // needs the amount order touched, as timestamps never change
+    void updateSortedViews(const EntryView& entry, bool add, bool amountOnly = false) {
+        if (!sortedViewsReady_) return;
+        for (size_t k = 0; k < (amountOnly ? 1 : SORT_KEY_COUNT); ++k) {
+            auto key = static_cast<SortKey>(k);
+            if (add) {
+                sortedViews_[k].insert(sortItem(key, entry));
+            } else {
+                sortedViews_[k].erase(sortItem(key, entry));
+            }
+        }
+    }
+
+    void rebuildSortedView(SortKey key) const {
+        std::vector<SortedView::Item> items;
+        items.reserve(entries_.size());
+        for (const auto& entry : entries_) items.push_back(sortItem(key, entry));
+        sortedViews_[static_cast<size_t>(key)].assign(std::move(items));
+    }
+
+    static std::int64_t dayNumber(std::chrono::year_month_day date) {
+        return std::chrono::sys_days(date).time_since_epoch().count();
+    }
 
 public:
     BudgetManager() = default;
 
-    void setExchangeRate(double rate) {
-        if (rate <= 0.0) {
-            throw std::invalid_argument("Exchange rate must be positive");
-        }
+    // Sets how many units of `currency` one BASE_CURRENCY buys
+    void setRate(Currency currency, double unitsPerBase) {
+        rates_.setRate(currency, unitsPerBase);
+        if (sortedViewsReady_) rebuildSortedView(SortKey::AMOUNT);
+        if (listener_) listener_->onRate(currency, unitsPerBase);
+    }
+
+    double getRate(Currency currency) const {
+        return rates_.getRate(currency);
+    }
 
-        exchangeRate_ = rate;
+    const CurrencyRates& getRates() const {
+        return rates_;
+    }
+
+    // The GBP to USD rate, kept for the original two-currency settings
+    void setExchangeRate(double rate) {
+        setRate(Currency::USD, rate);
     }
 
     double getExchangeRate() const {
-        return exchangeRate_;
+        return rates_.getRate(Currency::USD);
     }
 
-    std::string addEntry(std::string description, double amount, 
+    std::string addEntry(std::string description, Money amount, 
                         Category category, Currency currency) {
-        std::string id = std::to_string(nextId_++);
-        auto entry = std::make_unique<BudgetEntry>(id, std::move(description), 
-                                                   amount, category, currency);
-        entries_.push_back(std::move(entry));
+        EntryId id = nextId_++;
+        size_t row = entries_.append(id, description, amount, category, currency,
+                                     std::chrono::system_clock::now());
+        totals_.add(category, currency, amount);
+        if (timeIndexReady_) {
+            timeIndex_.add(localDays_.localDay(entries_.timestamps()[row]), category, currency, amount);
+        }
+        updateSortedViews(entries_[row], true);
+        if (listener_) listener_->onAdd(entries_[row]);
+        return std::to_string(id);
+    }
+
+    // Appends a batch under consecutive IDs, in order, and returns the first ID.
+    // The running totals are updated once, from a kernel pass over the new rows.
+    EntryId addEntries(std::span<const NewEntry> batch) {
+        EntryId first = nextId_;
+        size_t firstRow = entries_.rows();
+        if (firstRow + batch.size() > entries_.capacity()) {
+            entries_.reserve(std::max(firstRow + batch.size(), 2 * entries_.capacity()));
+        }
+        for (const auto& entry : batch) {
+            entries_.append(nextId_++, entry.description, entry.amount, entry.category, entry.currency,
+                            entry.timestamp);
+        }
+        totals_.merge(CategoryTotals::compute(HistogramInput{entries_.amounts().subspan(firstRow),
+                                                             entries_.categories().subspan(firstRow),
+                                                             entries_.currencies().subspan(firstRow)}));
+        if (timeIndexReady_) {
+            for (const auto& entry : batch) {
+                timeIndex_.add(localDays_.localDay(entry.timestamp), entry.category, entry.currency, entry.amount);
+            }
+        }
+        if (batch.size() > firstRow) {
+            sortedViewsReady_ = false; // re-sorting once beats inserting more rows than there were
+        } else {
+            for (size_t row = firstRow; row < entries_.rows(); ++row) updateSortedViews(entries_[row], true);
+        }
+        if (listener_) {
+            for (size_t row = firstRow; row < entries_.rows(); ++row) listener_->onAdd(entries_[row]);
+        }
+        return first;
+    }
+
+    // Inserts an entry that already carries an ID and timestamp, e.g. one read back
+    // from a file. The stored ID is kept unless it is 0 or already taken, in which
+    // case a fresh one is assigned. Returns the ID the entry ended up with.
+    EntryId restoreEntry(EntryId id, std::string_view description, Money amount, Category category,
+                         Currency currency, std::chrono::system_clock::time_point timestamp) {
+        if (id == 0 || entries_.contains(id)) {
+            id = nextId_;
+        }
+        nextId_ = std::max(nextId_, id + 1);
+        size_t row = entries_.append(id, description, amount, category, currency, timestamp);
+        totals_.add(category, currency, amount);
+        if (timeIndexReady_) {
+            timeIndex_.add(localDays_.localDay(timestamp), category, currency, amount);
+        }
+        updateSortedViews(entries_[row], true);
+        if (listener_) listener_->onAdd(entries_[row]);
         return id;
     }
 
     bool modifyEntry(const std::string& id, std::string description, 
-                    double amount, Category category, Currency currency) {
-        auto it = std::find_if(entries_.begin(), entries_.end(),
-            [&id](const auto& entry) { return entry->getId() == id; });
+                    Money amount, Category category, Currency currency) {
+        auto row = findRow(id);
         
-        if (it != entries_.end()) {
-            (*it)->setDescription(std::move(description));
-            (*it)->setAmount(amount);
-            (*it)->setCategory(category);
-            (*it)->setCurrency(currency);
+        if (row != EntryStore::NPOS) {
+            totals_.remove(entries_.categories()[row], entries_.currencies()[row],
+                           entries_.amounts()[row]);
+            if (timeIndexReady_) {
+                std::int64_t day = localDays_.localDay(entries_.timestamps()[row]);
+                timeIndex_.remove(day, entries_.categories()[row], entries_.currencies()[row],
+                                  entries_.amounts()[row]);
+                timeIndex_.add(day, category, currency, amount);
+            }
+            updateSortedViews(entries_[row], false, true);
+            entries_.update(row, description, amount, category, currency);
+            updateSortedViews(entries_[row], true, true);
+            totals_.add(category, currency, amount);
+            if (listener_) listener_->onModify(entries_[row]);
             return true;
         }
         return false;
     }
 
     bool deleteEntry(const std::string& id) {
-        auto it = std::find_if(entries_.begin(), entries_.end(),
-            [&id](const auto& entry) { return entry->getId() == id; });
+        auto row = findRow(id);
         
-        if (it != entries_.end()) {
-            entries_.erase(it);
+        if (row != EntryStore::NPOS) {
+            totals_.remove(entries_.categories()[row], entries_.currencies()[row],
+                           entries_.amounts()[row]);
+            if (timeIndexReady_) {
+                timeIndex_.remove(localDays_.localDay(entries_.timestamps()[row]), entries_.categories()[row],
+                                  entries_.currencies()[row], entries_.amounts()[row]);
+            }
+            updateSortedViews(entries_[row], false);
+            EntryId erased = entries_.ids()[row];
+            entries_.erase(row);
+            if (listener_) listener_->onDelete(erased);
             return true;
         }
         return false;
     }
 
-    const std::vector<std::unique_ptr<BudgetEntry>>& getEntries() const {
+    // Applies `mutation` to every entry matching `predicate`, in one pass.
+    // Returns the number of entries the mutation actually changed.
+    template <std::predicate<const EntryView&> Predicate, std::invocable<EntryChange&> Mutation>
+    size_t modifyWhere(Predicate predicate, Mutation mutation) {
+        size_t changed = 0;
+        for (size_t row = 0; row < entries_.rows(); ++row) {
+            if (!entries_.isLive(row)) continue;
+            EntryView entry = entries_[row];
+            if (!predicate(entry)) continue;
+
+            EntryChange before{entry.getDescription(), entry.getAmount(), entry.getCategory(), entry.getCurrency()};
+            EntryChange after = before;
+            mutation(after);
+            if (after == before) continue;
+
+            totals_.remove(before.category, before.currency, before.amount);
+            totals_.add(after.category, after.currency, after.amount);
+            if (timeIndexReady_) {
+                std::int64_t day = localDays_.localDay(entry.getTimestamp());
+                timeIndex_.remove(day, before.category, before.currency, before.amount);
+                timeIndex_.add(day, after.category, after.currency, after.amount);
+            }
+            updateSortedViews(entry, false, true);
+            entries_.update(row, after.description, after.amount, after.category, after.currency);
+            updateSortedViews(entries_[row], true, true);
+            if (listener_) listener_->onModify(entries_[row]);
+            ++changed;
+        }
+        return changed;
+    }
+
+    // Deletes every entry matching `predicate` in one compacting pass, which
+    // also sweeps out earlier tombstones. Returns the number deleted.
+    template <std::predicate<const EntryView&> Predicate>
+    size_t deleteWhere(Predicate predicate) {
+        std::vector<EntryId> erased;
+        size_t count = entries_.eraseIf([&](const EntryView& entry) {
+            if (!predicate(entry)) return false;
+            totals_.remove(entry.getCategory(), entry.getCurrency(), entry.getAmount());
+            if (timeIndexReady_) {
+                timeIndex_.remove(localDays_.localDay(entry.getTimestamp()), entry.getCategory(),
+                                  entry.getCurrency(), entry.getAmount());
+            }
+            updateSortedViews(entry, false);
+            if (listener_) erased.push_back(entry.getId());
+            return true;
+        });
+        for (EntryId id : erased) listener_->onDelete(id);
+        return count;
+    }
+
+    const EntryStore& getEntries() const {
         return entries_;
     }
 
-    std::vector<const BudgetEntry*> getEntriesByCategory(Category category) const {
-        std::vector<const BudgetEntry*> result;
-        for (const auto& entry : entries_) {
-            if (entry->getCategory() == category) {
-                result.push_back(entry.get());
+    std::vector<EntryView> getEntriesByCategory(Category category) const {
+        std::vector<EntryView> result;
+        auto categories = entries_.categories();
+        for (size_t row = 0; row < categories.size(); ++row) {
+            if (categories[row] == category) {
+                result.push_back(entries_[row]);
             }
         }
         return result;
     }
 
-    double getTotalByCategory(Category category, Currency currency) const {
-        double total = 0.0;
+    Money getTotalByCategory(Category category, Currency currency) const {
+        return totals_.getTotal(category, currency);
+    }
+
+    // Running per-(Category, Currency) totals and counts, maintained on every mutation
+    const CategoryTotals& getCategoryTotals() const {
+        return totals_;
+    }
+
+    // Ad-hoc totals over the rows for which `selection[row]` is non-zero, computed in
+    // a single kernel pass. `selection` is indexed by physical row (see EntryStore::rows).
+    CategoryTotals computeCategoryTotals(std::span<const std::uint8_t> selection) const {
+        return CategoryTotals::compute(entries_, selection);
+    }
+
+    template <std::predicate<const EntryView&> Predicate>
+    CategoryTotals computeCategoryTotals(Predicate predicate) const {
+        std::vector<std::uint8_t> selection(entries_.rows(), 0);
         for (const auto& entry : entries_) {
-            if (entry->getCategory() == category && entry->getCurrency() == currency) {
-                total += entry->getAmount();
-            }
+            selection[entry.getRow()] = predicate(entry) ? 1 : 0;
+        }
+        return computeCategoryTotals(std::span<const std::uint8_t>(selection));
+    }
+
+    // Totals of the entries dated (in local time) from `first` to `last`, inclusive,
+    // in O(log days) once the time index is built
+    CategoryTotals getTotalsBetween(std::chrono::year_month_day first, std::chrono::year_month_day last) const {
+        return timeIndex().totalsBetween(dayNumber(first), dayNumber(last) + 1);
+    }
+
+    CategoryTotals getTotalsForMonth(std::chrono::year_month month) const {
+        return timeIndex().totalsBetween(dayNumber(month / 1), dayNumber((month + std::chrono::months{1}) / 1));
+    }
+
+    // Builds the time index now instead of on the first time-based query. Once
+    // built, no const member modifies the manager, so a copy can be read from
+    // several threads at once (see ConcurrentBudgetManager).
+    void buildTimeIndex() const {
+        timeIndex();
+    }
+
+    // Keeps entry IDs ordered by amount (in BASE_CURRENCY at the current rates)
+    // and by timestamp from now on, so largest-first and newest-first queries
+    // walk an index instead of scanning every row (see Query::top). The
+    // orderings are sorted on the first query that asks for one, so a bulk
+    // load after this call pays one sort rather than an insert per row;
+    // afterwards each mutation updates them in place and a rate change re-sorts
+    // the amount order. Opt-in, since both orderings are kept for every entry
+    // and copied with the manager.
+    void enableSortedViews() {
+        sortedViewsEnabled_ = true;
+    }
+
+    // Sorts the orderings now instead of on the first query that needs them; like
+    // buildTimeIndex, makes the const members safe to call from several threads
+    void buildSortedViews() const {
+        if (!sortedViewsEnabled_ || sortedViewsReady_) return;
+        for (size_t k = 0; k < SORT_KEY_COUNT; ++k) rebuildSortedView(static_cast<SortKey>(k));
+        sortedViewsReady_ = true;
+    }
+
+    // The ordering by `key`, or nullptr if enableSortedViews has not been called
+    const SortedView* getSortedView(SortKey key) const {
+        if (!sortedViewsEnabled_) return nullptr;
+        buildSortedViews();
+        return &sortedViews_[static_cast<size_t>(key)];
+    }
+
+    // One entry per calendar month from the earliest to the latest entry
+    std::vector<MonthlyTotals> getMonthlyTotals() const {
+        const TimeIndex& index = timeIndex();
+        std::vector<MonthlyTotals> months;
+        if (index.empty()) {
+            return months;
+        }
+        auto toMonth = [](std::int64_t day) {
+            std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{day}}};
+            return date.year() / date.month();
+        };
+        for (auto month = toMonth(index.getFirstDay()); month <= toMonth(index.getLastDay());
+             month += std::chrono::months{1}) {
+            months.push_back(MonthlyTotals{month, getTotalsForMonth(month)});
         }
-        return total;
+        return months;
+    }
+
+    // Every category's total in `reporting`, each entry converted at the rates in
+    // force on its local day (current rates where `history` has no quote yet)
+    std::array<Money, CATEGORY_COUNT> getTotalsAtHistoricalRates(const RateHistory& history,
+                                                                 Currency reporting) const {
+        std::array<Money, CATEGORY_COUNT> result{};
+        auto amounts = entries_.amounts();
+        auto categories = entries_.categories();
+        auto currencies = entries_.currencies();
+        auto timestamps = entries_.timestamps();
+        // Caches of its own, so readers sharing this manager and `history` share no mutable state
+        TimestampFormatter localDays;
+        RateHistory::Cursor cursor;
+        for (size_t row = 0; row < entries_.rows(); ++row) {
+            auto category = static_cast<size_t>(categories[row]);
+            if (category >= CATEGORY_COUNT) continue; // tombstone
+            std::int64_t day = localDays.localDay(timestamps[row]);
+            result[category] += history.convert(amounts[row], currencies[row], reporting, day, rates_, cursor);
+        }
+        return result;
+    }
+
+    // The ID the next addEntry will hand out
+    EntryId getNextId() const {
+        return nextId_;
+    }
+
+    // Makes sure IDs below `id` are never handed out again (e.g. after restoring
+    // a snapshot whose highest IDs were deleted before it was taken)
+    void reserveIdsBelow(EntryId id) {
+        nextId_ = std::max(nextId_, id);
+        if (listener_) listener_->onSetting(BudgetSetting::NEXT_ID, id);
+    }
+
+    void reserve(size_t count) {
+        entries_.reserve(count);
     }
 
     void clear() {
         entries_.clear();
+        totals_.clear();
+        timeIndex_.clear();
+        timeIndexReady_ = false;
+        for (auto& view : sortedViews_) view.clear();
+        sortedViewsReady_ = false;
         nextId_ = 1;
+        if (listener_) listener_->onClear();
+    }
+
+    // Installs (or, with nullptr, removes) the mutation listener; at most one
+    void setListener(BudgetListener* listener) {
+        listener_ = listener;
     }
 
     size_t getEntryCount() const {
         return entries_.size();
     }
 
-    void setBabuIncome(double income) {
-        if (income < 0.0) {
+    void setBabuIncome(Money income) {
+        if (income < Money{}) {
             throw std::invalid_argument("Income must be non-negative");
         }
         babu_income_ = income;
+        if (listener_) listener_->onSetting(BudgetSetting::BABU_INCOME, income.toDouble());
     }
 
-    double getBabuIncome() const {
+    Money getBabuIncome() const {
         return babu_income_;
     }
 
-    double getIncome() const {
+    Money getIncome() const {
         return babu_income_ + mamu_income_;
     }
 
-    void setMamuIncome(double income) {
-        if (income < 0.0) {
+    void setMamuIncome(Money income) {
+        if (income < Money{}) {
             throw std::invalid_argument("Income must be non-negative");
         }
         mamu_income_ = income;
+        if (listener_) listener_->onSetting(BudgetSetting::MAMU_INCOME, income.toDouble());
     }
 
-    double getMamuIncome() const {
+    Money getMamuIncome() const {
         return mamu_income_;
     }
 };
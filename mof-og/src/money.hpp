@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <compare>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace budget {
+
+// An amount of money as a whole number of minor units (pence, cents).
+// Sums are exact integer additions, so totals do not depend on the order in
+// which entries are added and can be split across threads or SIMD lanes.
+class Money {
+public:
+    static constexpr std::int64_t MINOR_PER_MAJOR = 100;
+    // Longest text toChars() writes: sign, 19 digits and the decimal point
+    static constexpr std::size_t MAX_CHARS = 21;
+
+private:
+    // Largest double below 2^63, so it and its negation convert to int64_t
+    static constexpr double MAX_MINOR = 9223372036854774784.0;
+
+    std::int64_t minor_ = 0;
+
+    constexpr explicit Money(std::int64_t minor) : minor_(minor) {}
+
+    // Saturates out-of-range counts and maps NaN to zero, so the casts below are defined
+    static double clampMinor(double minor) {
+        return std::isnan(minor) ? 0.0 : std::clamp(minor, -MAX_MINOR, MAX_MINOR);
+    }
+
+public:
+    constexpr Money() = default;
+
+    static constexpr Money fromMinor(std::int64_t minor) {
+        return Money(minor);
+    }
+
+    // Rounds to the nearest minor unit, halves away from zero; saturates beyond
+    // the int64_t range, and NaN gives zero
+    static Money fromMajor(double major) {
+        return Money(std::llround(clampMinor(major * MINOR_PER_MAJOR)));
+    }
+
+    // Rounds a fractional number of minor units (e.g. after applying an exchange
+    // rate), halves away from zero, saturating as fromMajor; branch-free (the
+    // clamp compiles to min/max) so conversion loops stay tight
+    static Money fromMinorRounded(double minor) {
+        return Money(static_cast<std::int64_t>(clampMinor(minor + std::copysign(0.5, minor))));
+    }
+
+    // Parses "12", "-3.5", "0.07" exactly; extra decimals are rounded half away
+    // from zero. Other number forms (e.g. exponents) go through fromMajor.
+    // Amounts that do not fit in int64_t minor units are rejected.
+    static std::optional<Money> parse(std::string_view text) {
+        std::string_view digits = text;
+        bool negative = !digits.empty() && digits.front() == '-';
+        if (negative) digits.remove_prefix(1);
+
+        std::size_t point = digits.find('.');
+        std::string_view whole = digits.substr(0, point);
+        std::string_view fraction = point == std::string_view::npos ? std::string_view{} : digits.substr(point + 1);
+
+        std::int64_t major = 0;
+        bool plain = !whole.empty() || !fraction.empty();
+        if (!whole.empty()) {
+            auto [ptr, ec] = std::from_chars(whole.data(), whole.data() + whole.size(), major);
+            plain = plain && ec == std::errc{} && ptr == whole.data() + whole.size() && whole.front() != '-';
+        }
+        std::int64_t minor = 0;
+        for (std::size_t i = 0; plain && i < fraction.size(); ++i) {
+            unsigned digit = static_cast<unsigned char>(fraction[i]) - '0';
+            if (digit > 9) {
+                plain = false;
+            } else if (i < 2) {
+                minor = minor * 10 + digit;
+            } else if (i == 2 && digit >= 5) {
+                minor += 1;
+            }
+        }
+        if (plain) {
+            if (fraction.size() == 1) minor *= 10;
+            if (major > (std::numeric_limits<std::int64_t>::max() - minor) / MINOR_PER_MAJOR) return std::nullopt;
+            std::int64_t total = major * MINOR_PER_MAJOR + minor;
+            return Money(negative ? -total : total);
+        }
+
+        double value = 0.0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc{} || ptr != text.data() + text.size() || !std::isfinite(value) ||
+            std::abs(value * MINOR_PER_MAJOR) > MAX_MINOR) {
+            return std::nullopt;
+        }
+        return fromMajor(value);
+    }
+
+    constexpr std::int64_t getMinor() const { return minor_; }
+
+    // For display and ratios only; not exact beyond 2^53 minor units
+    constexpr double toDouble() const {
+        return static_cast<double>(minor_) / MINOR_PER_MAJOR;
+    }
+
+    // Writes "-12.05" style text into [first, last); returns one past the end
+    char* toChars(char* first, char* last) const {
+        std::uint64_t magnitude = minor_ < 0 ? 0 - static_cast<std::uint64_t>(minor_)
+                                             : static_cast<std::uint64_t>(minor_);
+        if (minor_ < 0 && first != last) *first++ = '-';
+        first = std::to_chars(first, last, magnitude / MINOR_PER_MAJOR).ptr;
+        if (last - first >= 3) {
+            std::uint64_t cents = magnitude % MINOR_PER_MAJOR;
+            *first++ = '.';
+            *first++ = static_cast<char>('0' + cents / 10);
+            *first++ = static_cast<char>('0' + cents % 10);
+        }
+        return first;
+    }
+
+    std::string toString() const {
+        char text[MAX_CHARS];
+        return std::string(text, toChars(text, text + sizeof(text)));
+    }
+
+    constexpr Money operator-() const { return Money(-minor_); }
+    constexpr Money operator+(Money other) const { return Money(minor_ + other.minor_); }
+    constexpr Money operator-(Money other) const { return Money(minor_ - other.minor_); }
+    constexpr Money& operator+=(Money other) { minor_ += other.minor_; return *this; }
+    constexpr Money& operator-=(Money other) { minor_ -= other.minor_; return *this; }
+
+    constexpr auto operator<=>(const Money&) const = default;
+};
+
+static_assert(sizeof(Money) == sizeof(std::int64_t), "Money columns are read as int64 arrays");
+
+} // namespace budget
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "manager.hpp"
+#include "money.hpp"
+#include "sorted_view.hpp"
+#include "store.hpp"
+
+namespace budget {
+
+struct PagerOptions {
+    std::size_t pageSize = 20;
+    std::size_t width = 80; // terminal columns; the description column takes what the others leave
+    bool colour = true;     // ANSI emphasis on the header and footer
+};
+
+// Renders a BudgetManager's entries a page at a time, in row order, into one
+// reusable buffer, so showing a page is a single write however many rows it
+// holds. The column layout, the padded category and currency cells and the
+// colour codes are worked out once, in the constructor; a row then costs a
+// few to_chars calls and copies.
+//
+// The pager remembers a physical row, so a mutation that compacts the store
+// can move it; build one per view.
+class EntryPager {
+private:
+    static constexpr std::size_t ID_WIDTH = 12;
+    static constexpr std::size_t AMOUNT_WIDTH = 10;
+    static constexpr std::size_t CATEGORY_WIDTH = 15;
+    static constexpr std::size_t CURRENCY_WIDTH = 10;
+    static constexpr std::size_t FIXED_WIDTH = ID_WIDTH + AMOUNT_WIDTH + 2 + CATEGORY_WIDTH + CURRENCY_WIDTH;
+    static constexpr std::size_t MIN_DESCRIPTION_WIDTH = 20;
+    static constexpr std::size_t MAX_DESCRIPTION_WIDTH = 60;
+
+    const BudgetManager& manager_;
+    PagerOptions options_;
+    std::size_t descriptionWidth_;
+    std::string_view emphasis_;
+    std::string_view reset_;
+    std::string header_;
+    std::array<std::string, CATEGORY_COUNT> categoryCells_;
+    std::array<std::string, CURRENCY_COUNT> currencyCells_;
+    std::string buffer_;
+    std::size_t first_ = 0;    // physical row the page starts at
+    std::size_t position_ = 0; // live rows before first_, kept as the pager moves
+
+    // Display columns, counting each UTF-8 sequence as one
+    static std::size_t columns(std::string_view text) {
+        return static_cast<std::size_t>(std::ranges::count_if(text, [](char c) { return (c & 0xC0) != 0x80; }));
+    }
+
+    // The longest prefix of `text` that fits in `width` columns without splitting a sequence
+    static std::string_view fit(std::string_view text, std::size_t width) {
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if ((text[i] & 0xC0) != 0x80 && used++ == width) return text.substr(0, i);
+        }
+        return text;
+    }
+
+    static void padRight(std::string& out, std::string_view text, std::size_t width) {
+        out += text;
+        std::size_t used = columns(text);
+        if (used < width) out.append(width - used, ' ');
+    }
+
+    static void padLeft(std::string& out, std::string_view text, std::size_t width) {
+        if (text.size() < width) out.append(width - text.size(), ' ');
+        out += text;
+    }
+
+    void appendRow(const EntryStore& entries, std::size_t row) {
+        char digits[24];
+        padRight(buffer_, std::string_view(digits, std::to_chars(digits, digits + sizeof(digits), entries.ids()[row]).ptr),
+                 ID_WIDTH);
+        padRight(buffer_, fit(entries.description(row), descriptionWidth_ - 2), descriptionWidth_);
+        char amount[Money::MAX_CHARS];
+        padLeft(buffer_, std::string_view(amount, entries.amounts()[row].toChars(amount, amount + sizeof(amount))),
+                AMOUNT_WIDTH);
+        buffer_ += "  ";
+        buffer_ += categoryCells_[static_cast<std::size_t>(entries.categories()[row])];
+        buffer_ += currencyCells_[static_cast<std::size_t>(entries.currencies()[row])];
+        buffer_ += '\n';
+    }
+
+    // The row after `count` live rows starting at `row`
+    std::size_t skipForward(std::size_t row, std::size_t count) const {
+        const EntryStore& entries = manager_.getEntries();
+        for (; row < entries.rows() && count > 0; ++row) count -= entries.isLive(row) ? 1 : 0;
+        return row;
+    }
+
+    // Moves back over up to `count` live rows from `row`, stopping at row 0;
+    // `skipped` is set to the number moved over
+    std::size_t skipBack(std::size_t row, std::size_t count, std::size_t& skipped) const {
+        const EntryStore& entries = manager_.getEntries();
+        skipped = 0;
+        while (row > 0 && skipped < count) skipped += entries.isLive(--row) ? 1 : 0;
+        return row;
+    }
+
+    // Moves to `row`, counting the live rows before it once
+    void moveTo(std::size_t row) {
+        auto before = manager_.getEntries().categories().first(row);
+        first_ = row;
+        position_ = before.size() - static_cast<std::size_t>(std::ranges::count(before, EntryStore::DEAD_CATEGORY));
+    }
+
+    bool anyLiveFrom(std::size_t row) const {
+        const EntryStore& entries = manager_.getEntries();
+        auto categories = entries.categories().subspan(std::min(row, entries.rows()));
+        return std::ranges::any_of(categories, [](Category c) { return c != EntryStore::DEAD_CATEGORY; });
+    }
+
+public:
+    EntryPager(const BudgetManager& manager, PagerOptions options = {})
+        : manager_(manager), options_(options),
+          descriptionWidth_(std::clamp(options.width > FIXED_WIDTH ? options.width - FIXED_WIDTH : 0,
+                                       MIN_DESCRIPTION_WIDTH, MAX_DESCRIPTION_WIDTH)),
+          emphasis_(options.colour ? "\033[1m" : ""), reset_(options.colour ? "\033[0m" : "") {
+        options_.pageSize = std::max<std::size_t>(options_.pageSize, 1);
+
+        for (Category category : CategoryManager::getAllCategories()) {
+            padRight(categoryCells_[static_cast<std::size_t>(category)], CategoryManager::toString(category),
+                     CATEGORY_WIDTH);
+        }
+        for (Currency currency : CurrencyConverter::getAllCurrencies()) {
+            padRight(currencyCells_[static_cast<std::size_t>(currency)], CurrencyConverter::toString(currency),
+                     CURRENCY_WIDTH);
+        }
+
+        header_ += emphasis_;
+        padRight(header_, "ID", ID_WIDTH);
+        padRight(header_, "Description", descriptionWidth_);
+        padLeft(header_, "Amount", AMOUNT_WIDTH);
+        header_ += "  ";
+        padRight(header_, "Category", CATEGORY_WIDTH);
+        header_ += "Currency";
+        header_ += reset_;
+        header_ += '\n';
+        header_.append(FIXED_WIDTH + descriptionWidth_, '-');
+        header_ += '\n';
+
+        // Descriptions may take up to four bytes a column
+        buffer_.reserve(header_.size() + (options_.pageSize + 2) * (FIXED_WIDTH + 4 * descriptionWidth_ + 1));
+    }
+
+    // The current page: header, rows and a position line, valid until the next call
+    std::string_view page() {
+        const EntryStore& entries = manager_.getEntries();
+        if (first_ > entries.rows()) moveTo(entries.rows());
+        buffer_.clear();
+        buffer_ += header_;
+
+        std::size_t shown = 0;
+        for (std::size_t row = first_; row < entries.rows() && shown < options_.pageSize; ++row) {
+            if (!entries.isLive(row)) continue;
+            appendRow(entries, row);
+            ++shown;
+        }
+
+        char digits[24];
+        auto number = [&](std::size_t value) {
+            buffer_.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+        };
+        buffer_ += emphasis_;
+        if (shown == 0) {
+            buffer_ += "No entries";
+        } else {
+            buffer_ += "Entries ";
+            number(getPosition() + 1);
+            buffer_ += "-";
+            number(getPosition() + shown);
+            buffer_ += " of ";
+            number(entries.size());
+        }
+        buffer_ += reset_;
+        buffer_ += '\n';
+        return buffer_;
+    }
+
+    // Index of the page's first entry among the live entries, from 0
+    std::size_t getPosition() const { return position_; }
+
+    std::size_t getPageSize() const { return options_.pageSize; }
+
+    void first() {
+        first_ = 0;
+        position_ = 0;
+    }
+
+    void last() {
+        std::size_t skipped = 0;
+        first_ = skipBack(manager_.getEntries().rows(), options_.pageSize, skipped);
+        position_ = manager_.getEntries().size() - skipped;
+    }
+
+    // Returns false, staying put, on the last page
+    bool next() {
+        std::size_t row = skipForward(first_, options_.pageSize);
+        if (!anyLiveFrom(row)) return false;
+        first_ = row;
+        position_ += options_.pageSize;
+        return true;
+    }
+
+    // Returns false on the first page
+    bool previous() {
+        if (position_ == 0) return false;
+        std::size_t skipped = 0;
+        first_ = skipBack(first_, options_.pageSize, skipped);
+        position_ -= skipped;
+        return true;
+    }
+
+    // Starts the page at the entry with ID `id`, through the ID index
+    bool jumpToId(EntryId id) {
+        std::size_t row = manager_.getEntries().find(id);
+        if (row == EntryStore::NPOS) return false;
+        moveTo(row);
+        return true;
+    }
+
+    // Starts the page at the earliest entry timestamped at or after `when`:
+    // a binary search when the rows are in time order, else a lookup in the
+    // manager's time order if enabled, else a scan. Returns false if there is none.
+    bool jumpToDate(std::chrono::system_clock::time_point when) {
+        const EntryStore& entries = manager_.getEntries();
+        auto timestamps = entries.timestamps();
+        std::size_t row = EntryStore::NPOS;
+        if (entries.isTimeOrdered()) {
+            row = static_cast<std::size_t>(std::ranges::lower_bound(timestamps, when) - timestamps.begin());
+            if (!anyLiveFrom(row)) row = EntryStore::NPOS;
+        } else if (const SortedView* byTime = manager_.getSortedView(SortKey::TIMESTAMP)) {
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+            if (const SortedView::Item* item = byTime->lowerBound(nanos)) row = entries.find(item->id);
+        } else {
+            for (std::size_t r = 0; r < entries.rows(); ++r) {
+                if (entries.isLive(r) && timestamps[r] >= when && (row == EntryStore::NPOS || timestamps[r] < timestamps[row])) {
+                    row = r;
+                }
+            }
+        }
+        if (row == EntryStore::NPOS) return false;
+        moveTo(row);
+        return true;
+    }
+};
+
+} // namespace budget
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace budget {
+
+class Parallel {
+public:
+    // Resolves a requested thread count; 0 means one per hardware thread
+    static unsigned resolveThreads(unsigned requested) {
+        if (requested != 0) return requested;
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Runs task(i) for every i in [0, tasks) on up to `threads` threads, the calling
+    // thread included, and returns once all of them have finished.
+    template <typename Task>
+    static void forEach(std::size_t tasks, unsigned threads, Task&& task) {
+        std::size_t workers = std::min<std::size_t>(threads, tasks);
+        if (workers <= 1) {
+            for (std::size_t i = 0; i < tasks; ++i) task(i);
+            return;
+        }
+
+        auto run = [&](std::size_t worker) {
+            for (std::size_t i = worker; i < tasks; i += workers) task(i);
+        };
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (std::size_t worker = 1; worker < workers; ++worker) {
+            pool.emplace_back(run, worker);
+        }
+        run(0);
+        for (auto& thread : pool) thread.join();
+    }
+};
+
+} // namespace budget
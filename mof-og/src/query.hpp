@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "enum_table.hpp"
+#include "manager.hpp"
+#include "money.hpp"
+#include "sorted_view.hpp"
+#include "store.hpp"
+#include "timestamp.hpp"
+#include "totals.hpp"
+
+namespace budget {
+
+// Filters over a BudgetManager's entries, composed by chaining and evaluated
+// lazily: rows() and entries() are std::ranges views that test each row's
+// columns as they are iterated, with no entries copied and no allocation per
+// call: the views carry the filter bounds by value and share the description
+// needles, so they stay valid after the Query itself is gone. Each filter
+// narrows the query further.
+//
+// Where an index answers part of the query it is used instead of a scan:
+// count() and totals() for category and currency filters alone come from the
+// running totals, and a time range is binary-searched when the store's rows are
+// in time order, so only the rows inside it are visited. With the manager's
+// sorted views enabled, top() and latest() walk them best-first and stop after
+// `n` matches instead of scanning.
+//
+// Views hold pointers into the manager and are invalidated by any mutation.
+//
+//   auto late = Query(manager).inCategory(Category::FOOD).amountBetween(money(20), money(100))
+//                             .onDates(2024y / 3 / 1, 2024y / 3 / 31);
+//   for (EntryView entry : late.entries()) ...
+class Query {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+private:
+    const BudgetManager* manager_;
+    std::bitset<CATEGORY_COUNT> categories_;
+    std::bitset<CURRENCY_COUNT> currencies_;
+    Money minAmount_ = Money::fromMinor(std::numeric_limits<std::int64_t>::min());
+    Money maxAmount_ = Money::fromMinor(std::numeric_limits<std::int64_t>::max());
+    std::optional<TimePoint> from_;
+    std::optional<TimePoint> until_;
+    // Lower-cased; a description must contain all of them. Shared with the views
+    // built from this Query, and replaced rather than modified when one is added.
+    std::shared_ptr<const std::vector<std::string>> needles_;
+
+    // Copied into the views so they do not depend on the Query outliving them
+    struct RowFilter {
+        const EntryStore* store;
+        std::bitset<CATEGORY_COUNT> categories;
+        std::bitset<CURRENCY_COUNT> currencies;
+        Money minAmount;
+        Money maxAmount;
+        std::optional<TimePoint> from;  // only set when the row range does not already apply them
+        std::optional<TimePoint> until;
+        std::shared_ptr<const std::vector<std::string>> needles;
+
+        bool operator()(std::size_t row) const {
+            auto category = static_cast<std::size_t>(store->categories()[row]);
+            if (category >= CATEGORY_COUNT || !categories.test(category)) return false; // tombstones too
+            if (!currencies.test(static_cast<std::size_t>(store->currencies()[row]))) return false;
+            Money amount = store->amounts()[row];
+            if (amount < minAmount || amount > maxAmount) return false;
+            TimePoint timestamp = store->timestamps()[row];
+            if ((from && timestamp < *from) || (until && timestamp >= *until)) return false;
+            if (!needles) return true;
+            std::string_view description = store->description(row);
+            return std::ranges::all_of(*needles, [&](const std::string& needle) {
+                return containsIgnoreCase(description, needle);
+            });
+        }
+    };
+
+    static bool containsIgnoreCase(std::string_view text, std::string_view lowerNeedle) {
+        return !std::ranges::search(text, lowerNeedle, [](char a, char b) { return asciiLower(a) == b; }).empty();
+    }
+
+    bool hasRowFilters() const {
+        return from_ || until_ || needles_ ||
+               minAmount_ != Money::fromMinor(std::numeric_limits<std::int64_t>::min()) ||
+               maxAmount_ != Money::fromMinor(std::numeric_limits<std::int64_t>::max());
+    }
+
+    const EntryStore& store() const { return manager_->getEntries(); }
+
+    // Physical rows that can match: all of them, or the time range's rows when
+    // the timestamp column is sorted
+    std::pair<std::size_t, std::size_t> rowRange() const {
+        const EntryStore& entries = store();
+        if (!entries.isTimeOrdered() || (!from_ && !until_)) return {0, entries.rows()};
+        auto timestamps = entries.timestamps();
+        auto first = from_ ? std::ranges::lower_bound(timestamps, *from_) : timestamps.begin();
+        auto last = until_ ? std::ranges::lower_bound(first, timestamps.end(), *until_) : timestamps.end();
+        return {static_cast<std::size_t>(first - timestamps.begin()), static_cast<std::size_t>(last - timestamps.begin())};
+    }
+
+    // `timeBounds` for rows reached other than through rowRange()
+    RowFilter filter(bool timeBounds) const {
+        return RowFilter{&store(), categories_, currencies_, minAmount_, maxAmount_,
+                         timeBounds ? from_ : std::nullopt, timeBounds ? until_ : std::nullopt, needles_};
+    }
+
+    // A candidate for a top-N result; `better` puts the larger value first, then the lower ID
+    struct Ranked {
+        std::int64_t value;
+        EntryId id;
+        std::size_t row;
+
+        static bool better(const Ranked& a, const Ranked& b) {
+            return a.value > b.value || (a.value == b.value && a.id < b.id);
+        }
+    };
+
+    // Keeps the best `n` seen in `heap`, whose front is the worst of them
+    static void keepBest(std::vector<Ranked>& heap, Ranked candidate, std::size_t n) {
+        if (heap.size() < n) {
+            heap.push_back(candidate);
+            std::ranges::push_heap(heap, Ranked::better);
+        } else if (n > 0 && Ranked::better(candidate, heap.front())) {
+            std::ranges::pop_heap(heap, Ranked::better);
+            heap.back() = candidate;
+            std::ranges::push_heap(heap, Ranked::better);
+        }
+    }
+
+    std::vector<EntryView> bestFirst(std::vector<Ranked> heap) const {
+        std::ranges::sort_heap(heap, Ranked::better);
+        std::vector<EntryView> result;
+        result.reserve(heap.size());
+        for (const Ranked& ranked : heap) result.push_back(store()[ranked.row]);
+        return result;
+    }
+
+    std::int64_t valueIn(std::size_t row, Currency reporting) const {
+        const EntryStore& entries = store();
+        return manager_->getRates().convert(entries.amounts()[row], entries.currencies()[row], reporting).getMinor();
+    }
+
+    // Walks `order` (best first), keeping matches, until `n` are found. Gives up
+    // after visiting as many IDs as a quarter of the rows a scan would test, each
+    // visit being an ID lookup, so a filter the order rarely satisfies falls
+    // back to scanning.
+    template <typename Order>
+    std::optional<std::vector<EntryView>> walk(Order&& order, std::size_t n) const {
+        auto [first, last] = rowRange();
+        std::size_t budget = (last - first) / 4;
+        const EntryStore& entries = store();
+        RowFilter matches = filter(true);
+        std::vector<EntryView> result;
+        std::size_t visited = 0;
+        for (const SortedView::Item& item : order) {
+            if (result.size() == n) break;
+            if (visited++ == budget) return std::nullopt;
+            std::size_t row = entries.find(item.id);
+            if (matches(row)) result.push_back(entries[row]);
+        }
+        return result;
+    }
+
+public:
+    explicit Query(const BudgetManager& manager) : manager_(&manager) {
+        categories_.set();
+        currencies_.set();
+    }
+
+    Query& inCategories(std::initializer_list<Category> categories) {
+        std::bitset<CATEGORY_COUNT> mask;
+        for (Category category : categories) mask.set(static_cast<std::size_t>(category));
+        categories_ &= mask;
+        return *this;
+    }
+
+    Query& inCategory(Category category) { return inCategories({category}); }
+
+    Query& inCurrencies(std::initializer_list<Currency> currencies) {
+        std::bitset<CURRENCY_COUNT> mask;
+        for (Currency currency : currencies) mask.set(static_cast<std::size_t>(currency));
+        currencies_ &= mask;
+        return *this;
+    }
+
+    Query& inCurrency(Currency currency) { return inCurrencies({currency}); }
+
+    // Amounts from `min` to `max` inclusive, in each entry's own currency
+    Query& amountBetween(Money min, Money max) {
+        minAmount_ = std::max(minAmount_, min);
+        maxAmount_ = std::min(maxAmount_, max);
+        return *this;
+    }
+
+    // Entries timestamped in [from, until)
+    Query& between(TimePoint from, TimePoint until) {
+        from_ = from_ ? std::max(*from_, from) : from;
+        until_ = until_ ? std::min(*until_, until) : until;
+        return *this;
+    }
+
+    // Entries dated from `first` to `last` inclusive, in local time (as getTotalsBetween)
+    Query& onDates(std::chrono::year_month_day first, std::chrono::year_month_day last) {
+        return between(localMidnight(first), localMidnight(std::chrono::sys_days(last) + std::chrono::days{1}));
+    }
+
+    // Case-insensitive (ASCII) substring match
+    Query& descriptionContains(std::string_view text) {
+        std::string lower(text);
+        for (char& c : lower) c = asciiLower(c);
+        if (lower.empty()) return *this;
+        auto needles = needles_ ? std::make_shared<std::vector<std::string>>(*needles_)
+                                : std::make_shared<std::vector<std::string>>();
+        needles->push_back(std::move(lower));
+        needles_ = std::move(needles);
+        return *this;
+    }
+
+    // Lazy view of the physical rows that match, in row order
+    auto rows() const {
+        auto [first, last] = rowRange();
+        if (categories_.none() || currencies_.none()) last = first;
+        return std::views::iota(first, last) | std::views::filter(filter(!store().isTimeOrdered()));
+    }
+
+    // Lazy view of the matching entries, in row order
+    auto entries() const {
+        const EntryStore* entries = &store();
+        return rows() | std::views::transform([entries](std::size_t row) { return (*entries)[row]; });
+    }
+
+    std::size_t count() const {
+        if (!hasRowFilters()) {
+            const CategoryTotals& totals = manager_->getCategoryTotals();
+            std::size_t count = 0;
+            for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+                for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                    if (categories_.test(c) && currencies_.test(k)) {
+                        count += totals.getCount(static_cast<Category>(c), static_cast<Currency>(k));
+                    }
+                }
+            }
+            return count;
+        }
+        return static_cast<std::size_t>(std::ranges::distance(rows()));
+    }
+
+    // Totals and counts of the matching entries per (Category, Currency)
+    CategoryTotals totals() const {
+        CategoryAmounts amounts{};
+        CategoryCounts counts{};
+        if (!hasRowFilters()) {
+            const CategoryTotals& totals = manager_->getCategoryTotals();
+            for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+                for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                    if (!categories_.test(c) || !currencies_.test(k)) continue;
+                    amounts[c][k] = totals.getTotal(static_cast<Category>(c), static_cast<Currency>(k));
+                    counts[c][k] = totals.getCount(static_cast<Category>(c), static_cast<Currency>(k));
+                }
+            }
+            return CategoryTotals(amounts, counts);
+        }
+        const EntryStore& entries = store();
+        for (std::size_t row : rows()) {
+            auto c = static_cast<std::size_t>(entries.categories()[row]);
+            auto k = static_cast<std::size_t>(entries.currencies()[row]);
+            amounts[c][k] += entries.amounts()[row];
+            ++counts[c][k];
+        }
+        return CategoryTotals(amounts, counts);
+    }
+
+    // Sum of the matching entries converted into `reporting` at the manager's rates
+    Money total(Currency reporting = BASE_CURRENCY) const {
+        Money sum;
+        for (Money amount : totals().getTotalsIn(manager_->getRates(), reporting)) sum += amount;
+        return sum;
+    }
+
+    // The `n` largest matching entries by amount in `reporting`, largest first
+    // (equal amounts by ascending ID). Walks the amount order when it is
+    // enabled and `reporting` is BASE_CURRENCY; otherwise a scan keeping a
+    // bounded heap, O(rows log n).
+    std::vector<EntryView> top(std::size_t n, Currency reporting = BASE_CURRENCY) const {
+        if (n == 0) return {};
+        const SortedView* byAmount = manager_->getSortedView(SortKey::AMOUNT);
+        if (byAmount && reporting == BASE_CURRENCY) {
+            if (auto found = walk(byAmount->descending(), n)) return *std::move(found);
+        }
+        const EntryStore& entries = store();
+        std::vector<Ranked> heap;
+        heap.reserve(n);
+        for (std::size_t row : rows()) keepBest(heap, {valueIn(row, reporting), entries.ids()[row], row}, n);
+        return bestFirst(std::move(heap));
+    }
+
+    // The `n` most recent matching entries, newest first (entries sharing a
+    // timestamp in no particular order). Reads the rows backwards when they are
+    // in time order, else walks the time order if enabled, else scans.
+    std::vector<EntryView> latest(std::size_t n) const {
+        if (n == 0) return {};
+        const EntryStore& entries = store();
+        if (entries.isTimeOrdered()) {
+            std::vector<EntryView> result;
+            for (std::size_t row : rows() | std::views::reverse | std::views::take(n)) result.push_back(entries[row]);
+            return result;
+        }
+        if (const SortedView* byTime = manager_->getSortedView(SortKey::TIMESTAMP)) {
+            if (auto found = walk(byTime->descending(), n)) return *std::move(found);
+        }
+        std::vector<Ranked> heap;
+        heap.reserve(n);
+        for (std::size_t row : rows()) {
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(entries.timestamps()[row].time_since_epoch());
+            keepBest(heap, {nanos.count(), entries.ids()[row], row}, n);
+        }
+        return bestFirst(std::move(heap));
+    }
+
+    // The `n` largest matching entries of each category, as top() does for one;
+    // a single scan keeping a bounded heap per category
+    std::array<std::vector<EntryView>, CATEGORY_COUNT> topByCategory(std::size_t n,
+                                                                    Currency reporting = BASE_CURRENCY) const {
+        const EntryStore& entries = store();
+        std::array<std::vector<Ranked>, CATEGORY_COUNT> heaps;
+        if (n > 0) {
+            for (std::size_t row : rows()) {
+                auto& heap = heaps[static_cast<std::size_t>(entries.categories()[row])];
+                keepBest(heap, {valueIn(row, reporting), entries.ids()[row], row}, n);
+            }
+        }
+        std::array<std::vector<EntryView>, CATEGORY_COUNT> result;
+        for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) result[c] = bestFirst(std::move(heaps[c]));
+        return result;
+    }
+
+    // Page `page` (from 0) of `size` matching entries, in row order
+    std::vector<EntryView> page(std::size_t page, std::size_t size) const {
+        std::vector<EntryView> result;
+        result.reserve(size);
+        for (EntryView entry : entries() | std::views::drop(page * size) | std::views::take(size)) {
+            result.push_back(entry);
+        }
+        return result;
+    }
+
+    // Start of `day` in local time
+    static TimePoint localMidnight(std::chrono::year_month_day day) {
+        char text[] = "0000-00-00 00:00:00";
+        auto put = [&](std::size_t pos, unsigned value, std::size_t width) {
+            for (std::size_t i = width; i-- > 0; value /= 10) text[pos + i] = static_cast<char>('0' + value % 10);
+        };
+        put(0, static_cast<unsigned>(static_cast<int>(day.year())), 4);
+        put(5, static_cast<unsigned>(day.month()), 2);
+        put(8, static_cast<unsigned>(day.day()), 2);
+        TimestampParser parser;
+        if (auto midnight = parser.parse(text)) return *midnight;
+        return TimePoint(std::chrono::sys_days(day)); // outside mktime's range; use UTC
+    }
+};
+
+} // namespace budget
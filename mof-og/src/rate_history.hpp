@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "csv.hpp"
+#include "currency.hpp"
+#include "mapped_file.hpp"
+#include "money.hpp"
+
+namespace budget {
+
+// Dated exchange rates, each quoted like CurrencyRates as units of a currency
+// per one BASE_CURRENCY. A quote holds from its day until the next quote for
+// the same currency. Lookups binary-search the currency's quotes; given a
+// Cursor they first try the interval that cursor's previous lookup landed in,
+// which entries close together in time almost always share. Lookups do not
+// modify the history, so threads can share it, each with its own Cursor.
+class RateHistory {
+public:
+    // Where one caller's previous lookups landed, per currency
+    struct Cursor {
+        std::array<std::size_t, CURRENCY_COUNT> cached{};
+    };
+
+private:
+    struct Series {
+        std::vector<std::int64_t> days; // days since 1970-01-01, ascending
+        std::vector<double> rates;
+    };
+
+    std::array<Series, CURRENCY_COUNT> series_;
+
+    static std::size_t index(Currency currency) { return static_cast<std::size_t>(currency); }
+
+public:
+    // Adds or replaces the quote for `currency` on `day`; quotes for the base
+    // currency are ignored, as it is always 1
+    void add(Currency currency, std::int64_t day, double unitsPerBase) {
+        if (currency == BASE_CURRENCY || !(unitsPerBase > 0.0) || !std::isfinite(unitsPerBase)) return;
+
+        Series& series = series_[index(currency)];
+        if (series.days.empty() || day > series.days.back()) {
+            series.days.push_back(day);
+            series.rates.push_back(unitsPerBase);
+            return;
+        }
+        auto position = std::lower_bound(series.days.begin(), series.days.end(), day);
+        auto offset = position - series.days.begin();
+        if (*position == day) {
+            series.rates[static_cast<std::size_t>(offset)] = unitsPerBase;
+        } else {
+            series.days.insert(position, day);
+            series.rates.insert(series.rates.begin() + offset, unitsPerBase);
+        }
+    }
+
+    // Reads "YYYY-MM-DD,<currency code>,<rate>" lines; a header line and any
+    // malformed lines are skipped. Returns false if the file cannot be read.
+    bool load(const std::string& filename) {
+        MappedFile file;
+        if (!file.open(filename)) return false;
+
+        CsvReader reader(file.view());
+        while (reader.next()) {
+            auto parts = reader.fields();
+            if (parts.size() != 3) continue;
+            auto day = parseDay(parts[0]);
+            auto currency = CurrencyConverter::tryFromString(parts[1]);
+            double rate = 0.0;
+            auto [ptr, ec] = std::from_chars(parts[2].data(), parts[2].data() + parts[2].size(), rate);
+            if (!day || !currency || ec != std::errc{} || ptr != parts[2].data() + parts[2].size()) continue;
+            add(*currency, *day, rate);
+        }
+        return true;
+    }
+
+    // Rate of `currency` in force on `day`, or `fallback` before its first quote
+    double getRate(Currency currency, std::int64_t day, double fallback, Cursor& cursor) const {
+        const Series& series = series_[index(currency)];
+        const std::size_t count = series.days.size();
+        if (count == 0 || day < series.days.front()) return fallback;
+
+        std::size_t& cached = cursor.cached[index(currency)];
+        std::size_t i = cached;
+        if (i >= count || day < series.days[i] || (i + 1 < count && day >= series.days[i + 1])) {
+            i = static_cast<std::size_t>(std::upper_bound(series.days.begin(), series.days.end(), day) -
+                                         series.days.begin()) - 1;
+            cached = i;
+        }
+        return series.rates[i];
+    }
+
+    double getRate(Currency currency, std::int64_t day, double fallback) const {
+        Cursor cursor;
+        return getRate(currency, day, fallback, cursor);
+    }
+
+    // Converts at the rates in force on `day`; currencies without a quote by
+    // then use `fallback`
+    Money convert(Money amount, Currency from, Currency to, std::int64_t day, const CurrencyRates& fallback,
+                  Cursor& cursor) const {
+        if (from == to) return amount;
+        double rate = getRate(to, day, fallback.getRate(to), cursor) / getRate(from, day, fallback.getRate(from), cursor);
+        return Money::fromMinorRounded(static_cast<double>(amount.getMinor()) * rate);
+    }
+
+    Money convert(Money amount, Currency from, Currency to, std::int64_t day, const CurrencyRates& fallback) const {
+        Cursor cursor;
+        return convert(amount, from, to, day, fallback, cursor);
+    }
+
+    // Quotes held, over all currencies
+    std::size_t size() const {
+        std::size_t count = 0;
+        for (const auto& series : series_) count += series.days.size();
+        return count;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    void clear() {
+        for (auto& series : series_) series = Series{};
+    }
+
+    // Parses "YYYY-MM-DD" into days since 1970-01-01
+    static std::optional<std::int64_t> parseDay(std::string_view text) {
+        int year = 0;
+        unsigned month = 0, day = 0;
+        if (text.size() != 10 || text[4] != '-' || text[7] != '-' ||
+            std::from_chars(text.data(), text.data() + 4, year).ptr != text.data() + 4 ||
+            std::from_chars(text.data() + 5, text.data() + 7, month).ptr != text.data() + 7 ||
+            std::from_chars(text.data() + 8, text.data() + 10, day).ptr != text.data() + 10) {
+            return std::nullopt;
+        }
+        std::chrono::year_month_day date{std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+        if (!date.ok()) return std::nullopt;
+        return std::chrono::sys_days(date).time_since_epoch().count();
+    }
+};
+
+} // namespace budget
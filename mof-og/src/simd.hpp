@@ -0,0 +1,9 @@
+#pragma once
+
+// x86 SIMD kernels are compiled per function with target attributes and picked
+// at runtime, so the build itself needs no -mavx2 style flags. Other targets
+// (and MSVC) use the portable scalar code paths.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BUDGET_X86_SIMD 1
+#include <immintrin.h>
+#endif
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.hpp"
+#include "manager.hpp"
+#include "money.hpp"
+#include "store.hpp"
+
+namespace budget {
+
+// On-disk header of a binary snapshot. All integers are native-endian; the
+// byte-order mark rejects files written on a machine with the other order.
+//
+// File layout, every section starting on an 8-byte boundary:
+//   header | rates (f64 units per base currency, one per currency) | ids (u32) | amounts (i64 minor units) | categories (u8) | currencies (u8) |
+//   timestamps (i64 ns since epoch) | description ends (u64, one per row) |
+//   description heap (bytes)
+// The checksum covers everything after the header.
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = {'M', 'O', 'F', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr std::uint32_t VERSION = 3; // 2: amounts and incomes in minor units; 3: rate table
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrderMark;
+    std::uint64_t rowCount;
+    std::uint64_t descriptionBytes;
+    std::uint64_t currencyCount; // entries in the rates section
+    std::int64_t babuIncome; // minor units
+    std::int64_t mamuIncome;
+    std::uint32_t nextId;
+    std::uint32_t reserved;
+    std::uint64_t checksum;
+};
+
+static_assert(sizeof(SnapshotHeader) == 72, "snapshot header layout must not change within a version");
+
+// FNV-1a over 64-bit words, fast enough to verify a snapshot at memory speed.
+// Streaming: splitting the input across update() calls gives the same value.
+class SnapshotChecksum {
+private:
+    static constexpr std::uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr std::uint64_t PRIME = 0x100000001b3ull;
+
+    std::uint64_t hash_ = OFFSET_BASIS;
+    char pending_[8] = {};
+    std::size_t pendingSize_ = 0;
+
+    void mix(const char* word) {
+        std::uint64_t value;
+        std::memcpy(&value, word, sizeof(value));
+        hash_ = (hash_ ^ value) * PRIME;
+        hash_ ^= hash_ >> 32;
+    }
+
+public:
+    void update(std::string_view bytes) {
+        std::size_t i = 0;
+        if (pendingSize_ > 0) {
+            while (pendingSize_ < 8 && i < bytes.size()) pending_[pendingSize_++] = bytes[i++];
+            if (pendingSize_ < 8) return;
+            mix(pending_);
+            pendingSize_ = 0;
+        }
+        for (; i + 8 <= bytes.size(); i += 8) {
+            mix(bytes.data() + i);
+        }
+        // Fewer than 8 bytes remain and pending_ is empty here
+        std::memcpy(pending_, bytes.data() + i, bytes.size() - i);
+        pendingSize_ = bytes.size() - i;
+    }
+
+    std::uint64_t value() const {
+        std::uint64_t hash = hash_;
+        for (std::size_t i = 0; i < pendingSize_; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(pending_[i])) * PRIME;
+        }
+        return hash;
+    }
+};
+
+// Read-only, memory-mapped snapshot. Columns are served straight from the
+// mapping, so opening a snapshot costs a header check and, optionally, one
+// checksum pass; nothing is parsed or copied.
+class SnapshotView {
+private:
+    MappedFile file_;
+    SnapshotHeader header_{};
+    std::span<const double> rates_;
+    std::span<const EntryId> ids_;
+    std::span<const Money> amounts_;
+    std::span<const Category> categories_;
+    std::span<const Currency> currencies_;
+    std::span<const std::int64_t> timestamps_;
+    std::span<const std::uint64_t> descriptionEnds_;
+    std::string_view descriptions_;
+
+    template <typename T>
+    static bool takeSection(std::string_view data, std::size_t& offset, std::size_t count, std::span<const T>& out) {
+        std::size_t bytes = count * sizeof(T);
+        if (offset > data.size() || bytes > data.size() - offset) return false;
+        out = std::span<const T>(reinterpret_cast<const T*>(data.data() + offset), count);
+        offset += SnapshotView::padded(bytes);
+        return true;
+    }
+
+public:
+    static constexpr std::size_t padded(std::size_t bytes) {
+        return (bytes + 7) & ~std::size_t{7};
+    }
+
+    // Returns true if the file starts with the snapshot magic
+    static bool isSnapshot(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary);
+        char magic[sizeof(SnapshotHeader::MAGIC)] = {};
+        file.read(magic, sizeof(magic));
+        return file && std::memcmp(magic, SnapshotHeader::MAGIC, sizeof(magic)) == 0;
+    }
+
+    bool open(const std::string& filename, bool verifyChecksum = true) {
+        if (!file_.open(filename)) return false;
+
+        std::string_view data = file_.view();
+        if (data.size() < sizeof(SnapshotHeader)) return false;
+        std::memcpy(&header_, data.data(), sizeof(SnapshotHeader));
+        if (std::memcmp(header_.magic, SnapshotHeader::MAGIC, sizeof(header_.magic)) != 0 ||
+            header_.version != SnapshotHeader::VERSION ||
+            header_.byteOrderMark != SnapshotHeader::BYTE_ORDER_MARK ||
+            header_.currencyCount > CURRENCY_COUNT) {
+            return false;
+        }
+
+        std::size_t rows = header_.rowCount;
+        std::size_t offset = sizeof(SnapshotHeader);
+        std::span<const char> heap;
+        if (!takeSection(data, offset, header_.currencyCount, rates_) || !takeSection(data, offset, rows, ids_) || !takeSection(data, offset, rows, amounts_) ||
+            !takeSection(data, offset, rows, categories_) || !takeSection(data, offset, rows, currencies_) ||
+            !takeSection(data, offset, rows, timestamps_) || !takeSection(data, offset, rows, descriptionEnds_) ||
+            !takeSection(data, offset, header_.descriptionBytes, heap)) {
+            return false;
+        }
+        descriptions_ = std::string_view(heap.data(), heap.size());
+        if (!descriptionEnds_.empty() && descriptionEnds_.back() != descriptions_.size()) return false;
+        if (!std::ranges::is_sorted(descriptionEnds_)) return false;
+        // The checksum only catches damage; a well-formed file can still carry bytes that
+        // would index past the totals (or pose as a tombstone), so reject those too
+        if (std::ranges::any_of(categories_, [](Category c) { return static_cast<std::size_t>(c) >= CATEGORY_COUNT; }) ||
+            std::ranges::any_of(currencies_, [](Currency c) { return static_cast<std::size_t>(c) >= CURRENCY_COUNT; })) {
+            return false;
+        }
+
+        if (verifyChecksum) {
+            SnapshotChecksum checksum;
+            checksum.update(data.substr(sizeof(SnapshotHeader)));
+            if (checksum.value() != header_.checksum) return false;
+        }
+        return true;
+    }
+
+    const SnapshotHeader& getHeader() const { return header_; }
+    std::size_t size() const { return ids_.size(); }
+
+    // Units of each currency, in enum order, per one BASE_CURRENCY
+    std::span<const double> rates() const { return rates_; }
+    std::span<const EntryId> ids() const { return ids_; }
+    std::span<const Money> amounts() const { return amounts_; }
+    std::span<const Category> categories() const { return categories_; }
+    std::span<const Currency> currencies() const { return currencies_; }
+    std::span<const std::int64_t> timestampNanos() const { return timestamps_; }
+
+    std::chrono::system_clock::time_point timestamp(std::size_t row) const {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamps_[row])));
+    }
+
+    std::string_view description(std::size_t row) const {
+        std::size_t begin = row == 0 ? 0 : descriptionEnds_[row - 1];
+        return descriptions_.substr(begin, descriptionEnds_[row] - begin);
+    }
+};
+
+class SnapshotWriter {
+private:
+    std::ofstream& file_;
+    SnapshotChecksum checksum_;
+
+    void write(std::string_view bytes) {
+        file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        checksum_.update(bytes);
+    }
+
+    void pad(std::size_t bytes) {
+        static constexpr char zeros[8] = {};
+        write(std::string_view(zeros, SnapshotView::padded(bytes) - bytes));
+    }
+
+    // Writes one column, skipping tombstoned rows, in bounded-size batches
+    template <typename T, typename Get>
+    void writeColumn(const EntryStore& store, Get get) {
+        constexpr std::size_t BATCH = 8192;
+        std::vector<T> batch;
+        batch.reserve(BATCH);
+        auto flush = [&] {
+            write(std::string_view(reinterpret_cast<const char*>(batch.data()), batch.size() * sizeof(T)));
+            batch.clear();
+        };
+        for (std::size_t row = 0; row < store.rows(); ++row) {
+            if (!store.isLive(row)) continue;
+            batch.push_back(get(row));
+            if (batch.size() == BATCH) flush();
+        }
+        flush();
+        pad(store.size() * sizeof(T));
+    }
+
+    explicit SnapshotWriter(std::ofstream& file) : file_(file) {}
+
+public:
+    static bool save(const BudgetManager& manager, const std::string& filename) {
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        const EntryStore& store = manager.getEntries();
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic));
+        header.version = SnapshotHeader::VERSION;
+        header.byteOrderMark = SnapshotHeader::BYTE_ORDER_MARK;
+        header.rowCount = store.size();
+        header.currencyCount = CURRENCY_COUNT;
+        header.babuIncome = manager.getBabuIncome().getMinor();
+        header.mamuIncome = manager.getMamuIncome().getMinor();
+        header.nextId = manager.getNextId();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // checksum patched below
+
+        SnapshotWriter writer(file);
+        std::array<double, CURRENCY_COUNT> rates{};
+        for (std::size_t i = 0; i < CURRENCY_COUNT; ++i) rates[i] = manager.getRate(static_cast<Currency>(i));
+        writer.write(std::string_view(reinterpret_cast<const char*>(rates.data()), sizeof(rates)));
+        writer.pad(sizeof(rates));
+        writer.writeColumn<EntryId>(store, [&](std::size_t row) { return store.ids()[row]; });
+        writer.writeColumn<Money>(store, [&](std::size_t row) { return store.amounts()[row]; });
+        writer.writeColumn<Category>(store, [&](std::size_t row) { return store.categories()[row]; });
+        writer.writeColumn<Currency>(store, [&](std::size_t row) { return store.currencies()[row]; });
+        writer.writeColumn<std::int64_t>(store, [&](std::size_t row) {
+            return static_cast<std::int64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(store.timestamps()[row].time_since_epoch()).count());
+        });
+        std::uint64_t descriptionEnd = 0;
+        writer.writeColumn<std::uint64_t>(store, [&](std::size_t row) {
+            return descriptionEnd += store.description(row).size();
+        });
+        for (const auto& entry : store) {
+            writer.write(entry.getDescription());
+        }
+        writer.pad(descriptionEnd);
+
+        header.descriptionBytes = descriptionEnd;
+        header.checksum = writer.checksum_.value();
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return static_cast<bool>(file);
+    }
+};
+
+} // namespace budget
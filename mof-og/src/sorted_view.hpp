@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ranges>
+#include <vector>
+
+#include "id_index.hpp"
+
+namespace budget {
+
+enum class SortKey : std::uint8_t {
+    AMOUNT,    // value in BASE_CURRENCY minor units at the current rates
+    TIMESTAMP  // nanoseconds since the epoch
+};
+
+inline constexpr std::size_t SORT_KEY_COUNT = 2;
+
+// Entry IDs kept sorted by a 64-bit key, ascending, with ties broken by
+// descending ID so that walking the view backwards lists the largest keys
+// first and equal keys oldest-ID first. Items live in blocks of at most
+// BLOCK_SIZE, so an insert or erase moves at most one block's items rather
+// than the whole permutation; blocks split when full and are dropped when
+// empty.
+class SortedView {
+public:
+    struct Item {
+        std::int64_t key;
+        EntryId id;
+
+        bool operator==(const Item&) const = default;
+    };
+
+private:
+    static constexpr std::size_t BLOCK_SIZE = 1024;
+
+    std::vector<std::vector<Item>> blocks_;
+    std::vector<std::int64_t> firstKeys_; // blocks_[i].front().key, for the block search
+    std::size_t size_ = 0;
+
+    static bool before(const Item& a, const Item& b) {
+        return a.key < b.key || (a.key == b.key && a.id > b.id);
+    }
+
+    // The block `item` belongs in: the last one whose first item is not after it
+    std::size_t blockFor(const Item& item) const {
+        auto it = std::upper_bound(firstKeys_.begin(), firstKeys_.end(), item.key);
+        std::size_t block = it == firstKeys_.begin() ? 0 : static_cast<std::size_t>(it - firstKeys_.begin()) - 1;
+        // Equal keys can straddle blocks; step back while the item sorts before this block's first
+        while (block > 0 && before(item, blocks_[block].front())) --block;
+        return block;
+    }
+
+public:
+    // Replaces the contents with `items`, in any order
+    void assign(std::vector<Item> items) {
+        std::sort(items.begin(), items.end(), before);
+        clear();
+        size_ = items.size();
+        for (std::size_t i = 0; i < items.size(); i += BLOCK_SIZE / 2) {
+            auto last = items.begin() + static_cast<std::ptrdiff_t>(std::min(items.size(), i + BLOCK_SIZE / 2));
+            blocks_.emplace_back(items.begin() + static_cast<std::ptrdiff_t>(i), last);
+            firstKeys_.push_back(blocks_.back().front().key);
+        }
+    }
+
+    void insert(Item item) {
+        ++size_;
+        if (blocks_.empty()) {
+            blocks_.push_back({item});
+            firstKeys_.push_back(item.key);
+            return;
+        }
+        std::size_t b = blockFor(item);
+        auto& block = blocks_[b];
+        block.insert(std::upper_bound(block.begin(), block.end(), item, before), item);
+        firstKeys_[b] = block.front().key;
+        if (block.size() > BLOCK_SIZE) {
+            auto middle = block.begin() + static_cast<std::ptrdiff_t>(block.size() / 2);
+            std::vector<Item> upper(middle, block.end());
+            block.erase(middle, block.end());
+            firstKeys_.insert(firstKeys_.begin() + static_cast<std::ptrdiff_t>(b) + 1, upper.front().key);
+            blocks_.insert(blocks_.begin() + static_cast<std::ptrdiff_t>(b) + 1, std::move(upper));
+        }
+    }
+
+    // Returns false if `item` (with exactly this key) is not in the view
+    bool erase(Item item) {
+        if (blocks_.empty()) return false;
+        std::size_t b = blockFor(item);
+        auto& block = blocks_[b];
+        auto it = std::lower_bound(block.begin(), block.end(), item, before);
+        if (it == block.end() || *it != item) return false;
+        block.erase(it);
+        --size_;
+        if (block.empty()) {
+            blocks_.erase(blocks_.begin() + static_cast<std::ptrdiff_t>(b));
+            firstKeys_.erase(firstKeys_.begin() + static_cast<std::ptrdiff_t>(b));
+        } else {
+            firstKeys_[b] = block.front().key;
+        }
+        return true;
+    }
+
+    void clear() {
+        blocks_.clear();
+        firstKeys_.clear();
+        size_ = 0;
+    }
+
+    // The first item whose key is at least `key`, or nullptr if there is none
+    const Item* lowerBound(std::int64_t key) const {
+        auto next = std::ranges::lower_bound(firstKeys_, key);
+        auto b = static_cast<std::size_t>(next - firstKeys_.begin());
+        // Every block before b - 1 ends at or below block b - 1's first key, which is below `key`
+        if (b > 0) {
+            const auto& block = blocks_[b - 1];
+            auto it = std::ranges::lower_bound(block, key, {}, &Item::key);
+            if (it != block.end()) return &*it;
+        }
+        return b < blocks_.size() ? &blocks_[b].front() : nullptr;
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Items in ascending key order, as a bidirectional view
+    auto ascending() const { return blocks_ | std::views::join; }
+
+    // Items in descending key order (equal keys by ascending ID)
+    auto descending() const { return ascending() | std::views::reverse; }
+};
+
+} // namespace budget
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "id_index.hpp"
+#include "money.hpp"
+#include "string_pool.hpp"
+
+namespace budget {
+
+class EntryStore;
+
+// Lightweight, non-owning view of one row in an EntryStore.
+// Like an iterator, it is invalidated by any mutation of the store.
+class EntryView {
+private:
+    const EntryStore* store_;
+    std::size_t row_;
+
+public:
+    EntryView(const EntryStore& store, std::size_t row) : store_(&store), row_(row) {}
+
+    EntryId getId() const;
+    std::string_view getDescription() const;
+    Money getAmount() const;
+    Category getCategory() const;
+    Currency getCurrency() const;
+    std::chrono::system_clock::time_point getTimestamp() const;
+
+    std::size_t getRow() const { return row_; }
+};
+
+// Column-oriented (struct-of-arrays) storage for budget entries.
+// Amounts, categories, currencies and timestamps live in contiguous columns so
+// that summaries scan plain arrays; descriptions are packed into one byte pool.
+//
+// Deleting a row leaves a tombstone (DEAD_CATEGORY, amount 0) so no other row
+// moves and category scans skip it without an extra check. Tombstones are
+// swept out once they outnumber live rows, which keeps deletes amortized O(1).
+class EntryStore {
+public:
+    static constexpr Category DEAD_CATEGORY = static_cast<Category>(0xFF);
+
+private:
+    static constexpr std::size_t MIN_COMPACT_ROWS = 64;
+
+    std::vector<EntryId> ids_;
+    std::vector<Money> amounts_;
+    std::vector<Category> categories_;
+    std::vector<Currency> currencies_;
+    std::vector<std::chrono::system_clock::time_point> timestamps_;
+
+    // Row i's description is descriptions_.view(descHandles_[i]); tombstones hold EMPTY
+    StringPool descriptions_;
+    std::vector<StringPool::Handle> descHandles_;
+
+    IdIndex index_;
+    std::size_t dead_ = 0;
+    bool timeOrdered_ = true; // timestamps never decrease from row to row
+
+    void storeDescription(std::size_t row, std::string_view description) {
+        // Store before releasing: `description` may point into the pool itself
+        StringPool::Handle handle = descriptions_.store(description);
+        descriptions_.release(descHandles_[row]);
+        descHandles_[row] = handle;
+    }
+
+    // Drops tombstones, preserving the order of live rows, and re-indexes IDs
+    void compactRows() {
+        std::size_t out = 0;
+        for (std::size_t row = 0; row < rows(); ++row) {
+            if (!isLive(row)) continue;
+            ids_[out] = ids_[row];
+            amounts_[out] = amounts_[row];
+            categories_[out] = categories_[row];
+            currencies_[out] = currencies_[row];
+            timestamps_[out] = timestamps_[row];
+            descHandles_[out] = descHandles_[row];
+            index_.insert(ids_[out], static_cast<std::uint32_t>(out));
+            ++out;
+        }
+        ids_.resize(out);
+        amounts_.resize(out);
+        categories_.resize(out);
+        currencies_.resize(out);
+        timestamps_.resize(out);
+        descHandles_.resize(out);
+        dead_ = 0;
+    }
+
+public:
+    class Iterator {
+    private:
+        const EntryStore* store_ = nullptr;
+        std::size_t row_ = 0;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = EntryView;
+        using difference_type = std::ptrdiff_t;
+
+        Iterator() = default;
+        Iterator(const EntryStore& store, std::size_t row) : store_(&store), row_(row) {
+            skipDead();
+        }
+
+        EntryView operator*() const { return EntryView(*store_, row_); }
+        Iterator& operator++() { ++row_; skipDead(); return *this; }
+        Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+        bool operator==(const Iterator& other) const { return row_ == other.row_; }
+
+    private:
+        void skipDead() {
+            while (row_ < store_->rows() && !store_->isLive(row_)) ++row_;
+        }
+    };
+
+    static constexpr std::size_t NPOS = static_cast<std::size_t>(-1);
+
+    // Number of live entries
+    std::size_t size() const { return ids_.size() - dead_; }
+    bool empty() const { return size() == 0; }
+
+    // Number of physical rows, including tombstones; bounds the column spans
+    std::size_t rows() const { return ids_.size(); }
+
+    bool isLive(std::size_t row) const { return categories_[row] != DEAD_CATEGORY; }
+
+    // Returns the row holding the given ID, or NPOS
+    std::size_t find(EntryId id) const {
+        std::uint32_t row = index_.find(id);
+        return row == IdIndex::NO_ROW ? NPOS : row;
+    }
+
+    bool contains(EntryId id) const { return index_.contains(id); }
+
+    // True while rows are in timestamp order (as when entries are added as they
+    // happen, or loaded from a file saved that way), so time ranges can be
+    // binary-searched. Tombstones keep their timestamps and do not break it.
+    bool isTimeOrdered() const { return timeOrdered_; }
+
+    // Rows the columns can hold before they next reallocate
+    std::size_t capacity() const { return ids_.capacity(); }
+
+    void reserve(std::size_t count) {
+        ids_.reserve(count);
+        amounts_.reserve(count);
+        categories_.reserve(count);
+        currencies_.reserve(count);
+        timestamps_.reserve(count);
+        descHandles_.reserve(count);
+    }
+
+    std::size_t append(EntryId id, std::string_view description, Money amount,
+                       Category category, Currency currency,
+                       std::chrono::system_clock::time_point timestamp) {
+        std::size_t row = rows();
+        if (row > 0 && timestamp < timestamps_.back()) timeOrdered_ = false;
+        index_.insert(id, static_cast<std::uint32_t>(row));
+        ids_.push_back(id);
+        amounts_.push_back(amount);
+        categories_.push_back(category);
+        currencies_.push_back(currency);
+        timestamps_.push_back(timestamp);
+        descHandles_.push_back(descriptions_.store(description));
+        return row;
+    }
+
+    void erase(std::size_t row) {
+        index_.erase(ids_[row]);
+        descriptions_.release(descHandles_[row]);
+        descHandles_[row] = StringPool::EMPTY;
+        amounts_[row] = Money{};
+        categories_[row] = DEAD_CATEGORY;
+        ++dead_;
+        if (dead_ > size() && rows() >= MIN_COMPACT_ROWS) {
+            compactRows();
+        }
+    }
+
+    void update(std::size_t row, std::string_view description, Money amount,
+                Category category, Currency currency) {
+        amounts_[row] = amount;
+        categories_[row] = category;
+        currencies_[row] = currency;
+        if (description != this->description(row)) storeDescription(row, description);
+    }
+
+    // Erases every live row for which `erase(EntryView)` is true and sweeps out
+    // all tombstones, in one pass that keeps the order of the remaining rows.
+    // `erase` sees each row before any later row moves. Returns the rows erased.
+    template <typename Predicate>
+    std::size_t eraseIf(Predicate&& erase) {
+        std::size_t out = 0;
+        std::size_t erased = 0;
+        for (std::size_t row = 0; row < rows(); ++row) {
+            if (!isLive(row)) continue;
+            if (erase(EntryView(*this, row))) {
+                index_.erase(ids_[row]);
+                descriptions_.release(descHandles_[row]);
+                ++erased;
+                continue;
+            }
+            if (out != row) {
+                ids_[out] = ids_[row];
+                amounts_[out] = amounts_[row];
+                categories_[out] = categories_[row];
+                currencies_[out] = currencies_[row];
+                timestamps_[out] = timestamps_[row];
+                descHandles_[out] = descHandles_[row];
+                index_.insert(ids_[out], static_cast<std::uint32_t>(out));
+            }
+            ++out;
+        }
+        ids_.resize(out);
+        amounts_.resize(out);
+        categories_.resize(out);
+        currencies_.resize(out);
+        timestamps_.resize(out);
+        descHandles_.resize(out);
+        dead_ = 0;
+        return erased;
+    }
+
+    void clear() {
+        ids_.clear();
+        amounts_.clear();
+        categories_.clear();
+        currencies_.clear();
+        timestamps_.clear();
+        descriptions_.clear();
+        descHandles_.clear();
+        index_.clear();
+        dead_ = 0;
+        timeOrdered_ = true;
+    }
+
+    // Column access
+    std::span<const EntryId> ids() const { return ids_; }
+    std::span<const Money> amounts() const { return amounts_; }
+    std::span<const Category> categories() const { return categories_; }
+    std::span<const Currency> currencies() const { return currencies_; }
+    std::span<const std::chrono::system_clock::time_point> timestamps() const { return timestamps_; }
+
+    std::string_view description(std::size_t row) const {
+        return descriptions_.view(descHandles_[row]);
+    }
+
+    // The pool behind description(); equal descriptions are stored once unless
+    // interning is switched off (only possible while the store is empty)
+    const StringPool& getDescriptionPool() const { return descriptions_; }
+
+    void setDescriptionInterning(bool interning) {
+        if (rows() == 0) descriptions_.setInterning(interning);
+    }
+
+    EntryView operator[](std::size_t row) const { return EntryView(*this, row); }
+
+    Iterator begin() const { return Iterator(*this, 0); }
+    Iterator end() const { return Iterator(*this, rows()); }
+};
+
+inline EntryId EntryView::getId() const { return store_->ids()[row_]; }
+inline std::string_view EntryView::getDescription() const { return store_->description(row_); }
+inline Money EntryView::getAmount() const { return store_->amounts()[row_]; }
+inline Category EntryView::getCategory() const { return store_->categories()[row_]; }
+inline Currency EntryView::getCurrency() const { return store_->currencies()[row_]; }
+inline std::chrono::system_clock::time_point EntryView::getTimestamp() const {
+    return store_->timestamps()[row_];
+}
+
+} // namespace budget
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace budget {
+
+// Arena-backed string storage handing out compact 32-bit handles.
+//
+// Bytes are bump-allocated from large chunks, so storing a string costs no
+// heap allocation of its own and clear() drops everything at once. With
+// interning on (the default), equal strings share one copy and one handle, found
+// through an open-addressing table of handles; handles are reference counted so
+// a string's bytes become garbage once nothing refers to it. Garbage is swept by
+// copying the live strings into a fresh arena once it exceeds half the arena.
+// Handles stay valid across sweeps; views returned by view() do not.
+class StringPool {
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle EMPTY = 0; // the empty string, never counted
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 256 << 10;
+    static constexpr std::size_t MIN_SWEEP_BYTES = CHUNK_SIZE;
+    static constexpr Handle FREE_SLOT = UINT32_MAX;
+    static constexpr Handle DELETED_SLOT = UINT32_MAX - 1;
+
+    struct Record {
+        const char* data = nullptr;
+        std::uint32_t length = 0;
+        std::uint32_t refs = 0;
+    };
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char* cursor_ = nullptr;
+    std::size_t remaining_ = 0;
+    std::vector<Record> records_{Record{}};
+    std::vector<Handle> freeHandles_;
+    std::vector<Handle> table_;    // power-of-two sized; FREE_SLOT, DELETED_SLOT or a handle
+    std::size_t tableUsed_ = 0;    // slots that are not FREE_SLOT
+    std::size_t usedBytes_ = 0;    // bytes handed out by the arena
+    std::size_t liveBytes_ = 0;    // bytes of strings still referenced
+    bool interning_ = true;
+
+    char* allocate(std::size_t size) {
+        usedBytes_ += size;
+        if (size > remaining_) {
+            // Long strings get a chunk of their own so the current one is not wasted
+            if (size >= CHUNK_SIZE / 4) {
+                chunks_.push_back(std::make_unique_for_overwrite<char[]>(size));
+                return chunks_.back().get();
+            }
+            chunks_.push_back(std::make_unique_for_overwrite<char[]>(CHUNK_SIZE));
+            cursor_ = chunks_.back().get();
+            remaining_ = CHUNK_SIZE;
+        }
+        char* result = cursor_;
+        cursor_ += size;
+        remaining_ -= size;
+        return result;
+    }
+
+    static std::size_t hash(std::string_view text) {
+        return std::hash<std::string_view>{}(text);
+    }
+
+    // Slot holding an equal string, or the free slot where it would go
+    std::size_t findSlot(std::string_view text) const {
+        std::size_t mask = table_.size() - 1;
+        for (std::size_t slot = hash(text) & mask;; slot = (slot + 1) & mask) {
+            Handle handle = table_[slot];
+            if (handle == FREE_SLOT || (handle != DELETED_SLOT && view(handle) == text)) {
+                return slot;
+            }
+        }
+    }
+
+    void insertIntoTable(Handle handle) {
+        std::size_t mask = table_.size() - 1;
+        std::size_t slot = hash(view(handle)) & mask;
+        while (table_[slot] != FREE_SLOT && table_[slot] != DELETED_SLOT) slot = (slot + 1) & mask;
+        if (table_[slot] == FREE_SLOT) ++tableUsed_;
+        table_[slot] = handle;
+    }
+
+    void eraseFromTable(Handle handle) {
+        std::size_t mask = table_.size() - 1;
+        std::size_t slot = hash(view(handle)) & mask;
+        while (table_[slot] != handle) slot = (slot + 1) & mask;
+        table_[slot] = DELETED_SLOT;
+    }
+
+    // Keeps the table at most half full, counting deleted slots
+    void growTable() {
+        if (!table_.empty() && (tableUsed_ + 1) * 2 <= table_.size()) return;
+        std::size_t live = records_.size() - freeHandles_.size();
+        table_.assign(std::max<std::size_t>(std::bit_ceil(live * 4), 64), FREE_SLOT);
+        tableUsed_ = 0;
+        for (Handle handle = 1; handle < records_.size(); ++handle) {
+            if (records_[handle].refs > 0) insertIntoTable(handle);
+        }
+    }
+
+    // Copies the live strings into a fresh arena; handles are unchanged
+    void sweep() {
+        std::vector<std::unique_ptr<char[]>> old = std::move(chunks_);
+        rehome();
+    }
+
+    // Points every live record at a copy of its bytes in a new arena
+    void rehome() {
+        chunks_.clear();
+        cursor_ = nullptr;
+        remaining_ = 0;
+        usedBytes_ = 0;
+        for (auto& record : records_) {
+            if (record.refs == 0) continue;
+            char* copy = allocate(record.length);
+            std::memcpy(copy, record.data, record.length);
+            record.data = copy;
+        }
+    }
+
+public:
+    StringPool() = default;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&&) = default;
+
+    // Copies keep the same handles; only live strings are copied, compacted
+    StringPool(const StringPool& other)
+        : records_(other.records_), freeHandles_(other.freeHandles_), table_(other.table_),
+          tableUsed_(other.tableUsed_), liveBytes_(other.liveBytes_), interning_(other.interning_) {
+        rehome();
+    }
+
+    StringPool& operator=(const StringPool& other) {
+        if (this != &other) *this = StringPool(other);
+        return *this;
+    }
+
+    // Interning can only be switched while the pool is empty
+    void setInterning(bool interning) {
+        if (records_.size() == 1) interning_ = interning;
+    }
+
+    bool isInterning() const { return interning_; }
+
+    // Stores `text` (or finds an equal interned copy) and returns a counted handle
+    Handle store(std::string_view text) {
+        if (text.empty()) return EMPTY;
+
+        std::size_t slot = 0;
+        if (interning_) {
+            growTable();
+            slot = findSlot(text);
+            if (table_[slot] != FREE_SLOT) {
+                ++records_[table_[slot]].refs;
+                return table_[slot];
+            }
+        }
+
+        char* data = allocate(text.size());
+        std::memcpy(data, text.data(), text.size());
+        liveBytes_ += text.size();
+
+        Handle handle;
+        if (!freeHandles_.empty()) {
+            handle = freeHandles_.back();
+            freeHandles_.pop_back();
+        } else {
+            handle = static_cast<Handle>(records_.size());
+            records_.emplace_back();
+        }
+        records_[handle] = Record{data, static_cast<std::uint32_t>(text.size()), 1};
+
+        if (interning_) {
+            table_[slot] = handle;
+            ++tableUsed_;
+        }
+        return handle;
+    }
+
+    // Drops one reference taken by store()
+    void release(Handle handle) {
+        if (handle == EMPTY || --records_[handle].refs > 0) return;
+
+        if (interning_) eraseFromTable(handle);
+        liveBytes_ -= records_[handle].length;
+        records_[handle] = Record{};
+        freeHandles_.push_back(handle);
+        if (usedBytes_ - liveBytes_ > usedBytes_ / 2 && usedBytes_ >= MIN_SWEEP_BYTES) {
+            sweep();
+        }
+    }
+
+    std::string_view view(Handle handle) const {
+        const Record& record = records_[handle];
+        return std::string_view(record.data, record.length);
+    }
+
+    // Frees the whole arena and every handle at once
+    void clear() {
+        chunks_.clear();
+        cursor_ = nullptr;
+        remaining_ = 0;
+        records_.assign(1, Record{});
+        records_.shrink_to_fit();
+        freeHandles_.clear();
+        table_.clear();
+        tableUsed_ = 0;
+        usedBytes_ = 0;
+        liveBytes_ = 0;
+    }
+
+    // Distinct strings currently stored
+    std::size_t getStringCount() const { return records_.size() - 1 - freeHandles_.size(); }
+    // Bytes of the strings still referenced
+    std::size_t getLiveBytes() const { return liveBytes_; }
+    // Bytes allocated from chunks, including garbage not yet swept
+    std::size_t getArenaBytes() const { return usedBytes_; }
+};
+
+} // namespace budget
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "kernels.hpp"
+#include "money.hpp"
+#include "totals.hpp"
+
+namespace budget {
+
+struct MonthlyTotals {
+    std::chrono::year_month month;
+    CategoryTotals totals;
+};
+
+// Per-(Category, Currency) totals and counts by local calendar day, kept in a
+// Fenwick tree so the totals of any range of days cost O(log days) instead of
+// a pass over the entries. Days are numbered from 1970-01-01; the covered
+// range grows (by rebuilding in O(days)) as entries near it arrive.
+//
+// Only days within MAX_GAP of the covered range join it. Outliers (e.g. a
+// mistyped year) are kept in a sparse map that range queries add in, so one
+// stray date costs a map node rather than a century of dense bins. If the
+// outliers pile up, the covered range is re-chosen as the largest run of
+// days no more than MAX_GAP apart.
+class TimeIndex {
+private:
+    static constexpr std::size_t BIN_COUNT = CATEGORY_COUNT * CURRENCY_COUNT;
+    static constexpr std::size_t MIN_DAYS = 64;
+    static constexpr std::int64_t MAX_GAP = 366;   // days
+    static constexpr std::size_t MAX_SPARSE = 256; // outlier days before the range is re-chosen
+
+    struct DayBins {
+        std::int64_t amounts[BIN_COUNT] = {}; // minor units
+        std::int64_t counts[BIN_COUNT] = {};
+
+        void add(const DayBins& other) {
+            for (std::size_t i = 0; i < BIN_COUNT; ++i) {
+                amounts[i] += other.amounts[i];
+                counts[i] += other.counts[i];
+            }
+        }
+    };
+
+    std::int64_t firstDay_ = 0;    // day stored at position 0
+    std::vector<DayBins> days_;    // per-day values, kept to rebuild the tree
+    std::vector<DayBins> tree_;    // 1-based Fenwick tree over days_
+    std::map<std::int64_t, DayBins> sparse_; // days outside the covered range
+    std::size_t sparseLimit_ = MAX_SPARSE;
+    std::int64_t denseMin_ = 0;    // earliest and latest day held in days_
+    std::int64_t denseMax_ = -1;
+    std::int64_t minDay_ = std::numeric_limits<std::int64_t>::max();
+    std::int64_t maxDay_ = std::numeric_limits<std::int64_t>::min();
+
+    static std::size_t bin(Category category, Currency currency) {
+        return static_cast<std::size_t>(category) * CURRENCY_COUNT + static_cast<std::size_t>(currency);
+    }
+
+    void rebuild() {
+        tree_.assign(days_.size() + 1, DayBins{});
+        for (std::size_t i = 1; i < tree_.size(); ++i) {
+            tree_[i].add(days_[i - 1]);
+            std::size_t parent = i + (i & (~i + 1));
+            if (parent < tree_.size()) tree_[parent].add(tree_[i]);
+        }
+    }
+
+    // Widens the covered range to include `day`, at least doubling it
+    void cover(std::int64_t day) {
+        auto size = static_cast<std::int64_t>(days_.size());
+        if (!days_.empty() && day >= firstDay_ && day < firstDay_ + size) return;
+
+        std::int64_t first = days_.empty() ? day : std::min(firstDay_, day);
+        std::int64_t last = days_.empty() ? day : std::max(firstDay_ + size - 1, day);
+        std::int64_t grown = std::max<std::int64_t>({last - first + 1, 2 * size, MIN_DAYS});
+        // Leave the spare room on the side that grew
+        if (!days_.empty() && day < firstDay_) first = last - grown + 1;
+
+        std::vector<DayBins> days(static_cast<std::size_t>(grown));
+        for (std::int64_t i = 0; i < size; ++i) {
+            days[static_cast<std::size_t>(firstDay_ + i - first)] = days_[static_cast<std::size_t>(i)];
+        }
+        // Outliers the wider range now reaches move in
+        for (auto it = sparse_.lower_bound(first); it != sparse_.end() && it->first < first + grown;) {
+            days[static_cast<std::size_t>(it->first - first)] = it->second;
+            denseMin_ = std::min(denseMin_, it->first);
+            denseMax_ = std::max(denseMax_, it->first);
+            it = sparse_.erase(it);
+        }
+        days_ = std::move(days);
+        firstDay_ = first;
+        rebuild();
+    }
+
+    // Covers `day` if it is near the days already held; false leaves it to the sparse map
+    bool place(std::int64_t day) {
+        if (days_.empty()) {
+            denseMin_ = denseMax_ = day;
+        } else if (day < denseMin_ - MAX_GAP || day > denseMax_ + MAX_GAP) {
+            return false;
+        }
+        cover(day);
+        denseMin_ = std::min(denseMin_, day);
+        denseMax_ = std::max(denseMax_, day);
+        return true;
+    }
+
+    // Makes the largest run of days no more than MAX_GAP apart the covered
+    // range and moves every other day to the sparse map
+    void recluster() {
+        std::map<std::int64_t, DayBins> all = std::move(sparse_);
+        sparse_.clear();
+        for (std::size_t i = 0; i < days_.size(); ++i) {
+            if (std::ranges::any_of(days_[i].counts, [](std::int64_t count) { return count != 0; })) {
+                all.emplace(firstDay_ + static_cast<std::int64_t>(i), days_[i]);
+            }
+        }
+        if (all.empty()) {
+            days_.clear();
+            tree_.clear();
+            return;
+        }
+
+        std::int64_t bestFirst = all.begin()->first, bestLast = bestFirst, runFirst = bestFirst, previous = bestFirst;
+        std::size_t bestDays = 0, runDays = 0;
+        for (const auto& [day, bins] : all) {
+            if (day - previous > MAX_GAP) {
+                runFirst = day;
+                runDays = 0;
+            }
+            previous = day;
+            if (++runDays > bestDays) {
+                bestDays = runDays;
+                bestFirst = runFirst;
+                bestLast = day;
+            }
+        }
+
+        firstDay_ = bestFirst;
+        days_.assign(static_cast<std::size_t>(std::max<std::int64_t>(bestLast - bestFirst + 1, MIN_DAYS)), DayBins{});
+        for (auto& [day, bins] : all) {
+            if (day >= bestFirst && day <= bestLast) {
+                days_[static_cast<std::size_t>(day - bestFirst)] = bins;
+            } else {
+                sparse_.emplace(day, bins);
+            }
+        }
+        denseMin_ = bestFirst;
+        denseMax_ = bestLast;
+        sparseLimit_ = std::max(MAX_SPARSE, 2 * sparse_.size());
+        rebuild();
+    }
+
+    void update(std::int64_t day, std::size_t key, std::int64_t amount, std::int64_t count) {
+        minDay_ = std::min(minDay_, day);
+        maxDay_ = std::max(maxDay_, day);
+        bool covered = !days_.empty() && day >= firstDay_ && day < firstDay_ + static_cast<std::int64_t>(days_.size());
+        if (!covered && !place(day)) {
+            DayBins& bins = sparse_[day];
+            bins.amounts[key] += amount;
+            bins.counts[key] += count;
+            if (sparse_.size() > sparseLimit_) recluster();
+            return;
+        }
+        auto position = static_cast<std::size_t>(day - firstDay_);
+        days_[position].amounts[key] += amount;
+        days_[position].counts[key] += count;
+        for (std::size_t i = position + 1; i < tree_.size(); i += i & (~i + 1)) {
+            tree_[i].amounts[key] += amount;
+            tree_[i].counts[key] += count;
+        }
+    }
+
+    // Sum of the first `count` stored days into `out`
+    void prefix(std::size_t count, DayBins& out) const {
+        for (std::size_t i = std::min(count, days_.size()); i > 0; i -= i & (~i + 1)) {
+            out.add(tree_[i]);
+        }
+    }
+
+    std::size_t positionOf(std::int64_t day) const {
+        return static_cast<std::size_t>(std::clamp<std::int64_t>(day - firstDay_, 0,
+                                                                 static_cast<std::int64_t>(days_.size())));
+    }
+
+public:
+    void add(std::int64_t day, Category category, Currency currency, Money amount) {
+        update(day, bin(category, currency), amount.getMinor(), 1);
+    }
+
+    void remove(std::int64_t day, Category category, Currency currency, Money amount) {
+        update(day, bin(category, currency), -amount.getMinor(), -1);
+    }
+
+    // Totals of the entries on days [firstDay, endDay)
+    CategoryTotals totalsBetween(std::int64_t firstDay, std::int64_t endDay) const {
+        DayBins upper, lower;
+        if (firstDay < endDay) {
+            prefix(positionOf(endDay), upper);
+            prefix(positionOf(firstDay), lower);
+            for (auto it = sparse_.lower_bound(firstDay); it != sparse_.end() && it->first < endDay; ++it) {
+                upper.add(it->second);
+            }
+        }
+        CategoryAmounts amounts{};
+        CategoryCounts counts{};
+        for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+            for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                std::size_t key = c * CURRENCY_COUNT + k;
+                counts[c][k] = static_cast<std::size_t>(upper.counts[key] - lower.counts[key]);
+                amounts[c][k] = Money::fromMinor(upper.amounts[key] - lower.amounts[key]);
+            }
+        }
+        return CategoryTotals(amounts, counts);
+    }
+
+    // Earliest and latest day that ever held an entry; getFirstDay() > getLastDay() if none
+    std::int64_t getFirstDay() const { return minDay_; }
+    std::int64_t getLastDay() const { return maxDay_; }
+    bool empty() const { return minDay_ > maxDay_; }
+
+    // Days held in dense bins, slack included, and days held as outliers
+    std::size_t getCoveredDays() const { return days_.size(); }
+    std::size_t getOutlierDays() const { return sparse_.size(); }
+
+    void clear() {
+        firstDay_ = 0;
+        days_.clear();
+        tree_.clear();
+        sparse_.clear();
+        sparseLimit_ = MAX_SPARSE;
+        denseMin_ = 0;
+        denseMax_ = -1;
+        minDay_ = std::numeric_limits<std::int64_t>::max();
+        maxDay_ = std::numeric_limits<std::int64_t>::min();
+    }
+};
+
+} // namespace budget
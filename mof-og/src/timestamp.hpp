@@ -0,0 +1,193 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace budget {
+
+// Parses "YYYY-MM-DD HH:MM:SS" local-time stamps, as written by FileIO.
+// Converting local time to UTC needs the zone offset, which only changes at
+// DST transitions; it is looked up once per calendar day and reused for every
+// row on that day. Days containing a transition fall back to std::mktime.
+class TimestampParser {
+private:
+    std::int64_t cachedDay_ = std::numeric_limits<std::int64_t>::min();
+    std::int64_t cachedOffset_ = 0; // local minus UTC, in seconds
+    bool cachedUniform_ = false;    // true if the offset holds for the whole day
+
+    static bool parseDigits(std::string_view text, std::size_t pos, std::size_t count, int& value) {
+        value = 0;
+        for (std::size_t i = pos; i < pos + count; ++i) {
+            unsigned digit = static_cast<unsigned char>(text[i]) - '0';
+            if (digit > 9) return false;
+            value = value * 10 + static_cast<int>(digit);
+        }
+        return true;
+    }
+
+    static std::optional<std::time_t> toUtc(const std::chrono::year_month_day& date, int hour, int minute,
+                                            int second) {
+        std::tm local{};
+        local.tm_year = static_cast<int>(date.year()) - 1900;
+        local.tm_mon = static_cast<int>(static_cast<unsigned>(date.month())) - 1;
+        local.tm_mday = static_cast<int>(static_cast<unsigned>(date.day()));
+        local.tm_hour = hour;
+        local.tm_min = minute;
+        local.tm_sec = second;
+        local.tm_isdst = -1;
+        std::time_t utc = std::mktime(&local);
+        if (utc == static_cast<std::time_t>(-1)) return std::nullopt;
+        return utc;
+    }
+
+public:
+    std::optional<std::chrono::system_clock::time_point> parse(std::string_view text) {
+        if (text.size() != 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' ||
+            text[13] != ':' || text[16] != ':') {
+            return std::nullopt;
+        }
+
+        int year, month, day, hour, minute, second;
+        if (!parseDigits(text, 0, 4, year) || !parseDigits(text, 5, 2, month) ||
+            !parseDigits(text, 8, 2, day) || !parseDigits(text, 11, 2, hour) ||
+            !parseDigits(text, 14, 2, minute) || !parseDigits(text, 17, 2, second)) {
+            return std::nullopt;
+        }
+
+        std::chrono::year_month_day date{std::chrono::year{year},
+                                         std::chrono::month{static_cast<unsigned>(month)},
+                                         std::chrono::day{static_cast<unsigned>(day)}};
+        if (!date.ok() || hour > 23 || minute > 59 || second > 60) {
+            return std::nullopt;
+        }
+
+        std::int64_t localDay = std::chrono::sys_days(date).time_since_epoch().count();
+        std::int64_t localSeconds = localDay * 86400 + hour * 3600 + minute * 60 + second;
+
+        if (localDay != cachedDay_) {
+            auto startOfDay = toUtc(date, 0, 0, 0);
+            auto endOfDay = toUtc(date, 23, 59, 59);
+            if (!startOfDay || !endOfDay) return std::nullopt;
+            cachedDay_ = localDay;
+            cachedOffset_ = localDay * 86400 - static_cast<std::int64_t>(*startOfDay);
+            cachedUniform_ = localDay * 86400 + 86399 - static_cast<std::int64_t>(*endOfDay) == cachedOffset_;
+        }
+
+        std::int64_t utc;
+        if (cachedUniform_) {
+            utc = localSeconds - cachedOffset_;
+        } else {
+            auto exact = toUtc(date, hour, minute, second);
+            if (!exact) return std::nullopt;
+            utc = static_cast<std::int64_t>(*exact);
+        }
+        return std::chrono::system_clock::time_point(std::chrono::seconds(utc));
+    }
+};
+
+// Formats time points as "YYYY-MM-DD HH:MM:SS" in local time, the inverse of
+// TimestampParser. The date prefix and zone offset are computed once per local
+// day (with the thread-safe localtime_r) and reused for every later stamp that
+// falls on the same day; days containing a DST transition are converted one
+// stamp at a time.
+class TimestampFormatter {
+public:
+    static constexpr std::size_t LENGTH = 19;
+
+private:
+    std::int64_t windowBegin_ = 1; // UTC seconds [begin, end) sharing prefix and offset
+    std::int64_t windowEnd_ = 0;
+    std::int64_t offset_ = 0;      // local minus UTC, in seconds
+    std::int64_t localDay_ = 0;
+    char text_[LENGTH] = {};
+
+    static bool toLocal(std::int64_t utc, std::tm& local) {
+        auto time = static_cast<std::time_t>(utc);
+#ifdef _WIN32
+        return localtime_s(&local, &time) == 0;
+#else
+        return localtime_r(&time, &local) != nullptr;
+#endif
+    }
+
+    static std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+        return value / divisor - (value % divisor < 0 ? 1 : 0);
+    }
+
+    // Local minus UTC at `utc`; 0 if the conversion fails
+    static std::int64_t offsetAt(std::int64_t utc, std::tm& local) {
+        if (!toLocal(utc, local)) {
+            local = std::tm{};
+            return 0;
+        }
+        std::chrono::year_month_day date{std::chrono::year{local.tm_year + 1900},
+                                         std::chrono::month{static_cast<unsigned>(local.tm_mon + 1)},
+                                         std::chrono::day{static_cast<unsigned>(local.tm_mday)}};
+        std::int64_t localSeconds = std::chrono::sys_days(date).time_since_epoch().count() * 86400 +
+                                    local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+        return localSeconds - utc;
+    }
+
+    static void writeDigits(char* out, std::int64_t value, std::size_t count) {
+        for (std::size_t i = count; i-- > 0;) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    void refresh(std::int64_t utc) {
+        std::tm local{};
+        offset_ = offsetAt(utc, local);
+        localDay_ = floorDiv(utc + offset_, 86400);
+
+        std::int64_t dayBegin = localDay_ * 86400 - offset_;
+        std::tm edge{};
+        if (offsetAt(dayBegin, edge) == offset_ && offsetAt(dayBegin + 86399, edge) == offset_) {
+            windowBegin_ = dayBegin;
+            windowEnd_ = dayBegin + 86400;
+        } else {
+            windowBegin_ = utc;
+            windowEnd_ = utc + 1;
+        }
+
+        std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{localDay_}}};
+        writeDigits(text_, static_cast<int>(date.year()), 4);
+        text_[4] = '-';
+        writeDigits(text_ + 5, static_cast<unsigned>(date.month()), 2);
+        text_[7] = '-';
+        writeDigits(text_ + 8, static_cast<unsigned>(date.day()), 2);
+        text_[10] = ' ';
+        text_[13] = ':';
+        text_[16] = ':';
+    }
+
+public:
+    // The returned view is valid until the next call
+    std::string_view format(std::chrono::system_clock::time_point timestamp) {
+        std::int64_t utc = std::chrono::floor<std::chrono::seconds>(timestamp).time_since_epoch().count();
+        if (utc < windowBegin_ || utc >= windowEnd_) {
+            refresh(utc);
+        }
+
+        std::int64_t secondOfDay = utc + offset_ - localDay_ * 86400;
+        writeDigits(text_ + 11, secondOfDay / 3600, 2);
+        writeDigits(text_ + 14, secondOfDay / 60 % 60, 2);
+        writeDigits(text_ + 17, secondOfDay % 60, 2);
+        return std::string_view(text_, LENGTH);
+    }
+
+    // Local calendar day containing `timestamp`, in days since 1970-01-01
+    std::int64_t localDay(std::chrono::system_clock::time_point timestamp) {
+        std::int64_t utc = std::chrono::floor<std::chrono::seconds>(timestamp).time_since_epoch().count();
+        if (utc < windowBegin_ || utc >= windowEnd_) {
+            refresh(utc);
+        }
+        return localDay_;
+    }
+};
+
+} // namespace budget
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "category.hpp"
+#include "currency.hpp"
+#include "kernels.hpp"
+#include "money.hpp"
+#include "store.hpp"
+
+namespace budget {
+
+// Running totals and entry counts per (Category, Currency).
+// BudgetManager keeps one of these in step with every mutation so that a full
+// category summary costs O(categories) instead of a pass over the ledger.
+class CategoryTotals {
+private:
+    CategoryAmounts totals_{};
+    CategoryCounts counts_{};
+
+    static std::size_t index(Category category) { return static_cast<std::size_t>(category); }
+    static std::size_t index(Currency currency) { return static_cast<std::size_t>(currency); }
+
+public:
+    CategoryTotals() = default;
+    CategoryTotals(const CategoryAmounts& totals, const CategoryCounts& counts) : totals_(totals), counts_(counts) {}
+
+    // Computes totals from scratch in one pass of the histogram kernel
+    static CategoryTotals compute(const HistogramInput& input) {
+        CategoryTotals result;
+        HistogramKernel::accumulate(input, result.totals_, result.counts_);
+        return result;
+    }
+
+    static CategoryTotals compute(const EntryStore& store, std::span<const std::uint8_t> selection = {}) {
+        return compute(HistogramInput{store.amounts(), store.categories(), store.currencies(), selection});
+    }
+
+    void add(Category category, Currency currency, Money amount) {
+        totals_[index(category)][index(currency)] += amount;
+        ++counts_[index(category)][index(currency)];
+    }
+
+    void remove(Category category, Currency currency, Money amount) {
+        totals_[index(category)][index(currency)] -= amount;
+        --counts_[index(category)][index(currency)];
+    }
+
+    // Adds another set of totals into this one, e.g. to roll up several files
+    void merge(const CategoryTotals& other) {
+        for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+            for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                totals_[c][k] += other.totals_[c][k];
+                counts_[c][k] += other.counts_[c][k];
+            }
+        }
+    }
+
+    Money getTotal(Category category, Currency currency) const {
+        return totals_[index(category)][index(currency)];
+    }
+
+    std::size_t getCount(Category category, Currency currency) const {
+        return counts_[index(category)][index(currency)];
+    }
+
+    // Each category's total over all currencies, converted into `reporting`.
+    // Converts the per-currency sums, one batch per currency, rather than the
+    // entries, so the cost does not depend on how many entries there are.
+    std::array<Money, CATEGORY_COUNT> getTotalsIn(const CurrencyRates& rates, Currency reporting) const {
+        std::array<Money, CATEGORY_COUNT> result{};
+        std::array<Money, CATEGORY_COUNT> column{};
+        for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+            for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) column[c] = totals_[c][k];
+            rates.convert(column, column, static_cast<Currency>(k), reporting);
+            for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) result[c] += column[c];
+        }
+        return result;
+    }
+
+    std::size_t getCount(Category category) const {
+        std::size_t count = 0;
+        for (std::size_t n : counts_[index(category)]) count += n;
+        return count;
+    }
+
+    void clear() {
+        totals_ = {};
+        counts_ = {};
+    }
+
+    // Recomputes everything from the store and compares; O(rows), for tests
+    bool matches(const EntryStore& store) const {
+        CategoryTotals rescan = compute(store);
+        for (std::size_t c = 0; c < CATEGORY_COUNT; ++c) {
+            for (std::size_t k = 0; k < CURRENCY_COUNT; ++k) {
+                if (counts_[c][k] != rescan.counts_[c][k]) return false;
+                if (totals_[c][k] != rescan.totals_[c][k]) return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace budget
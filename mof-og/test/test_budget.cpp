@@ -1,32 +1,62 @@
 #include <iostream>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "../src/manager.hpp"
+#include "../src/pager.hpp"
+#include "../src/query.hpp"
+#include "../src/sorted_view.hpp"
+#include "../src/batch.hpp"
+#include "../src/concurrent_manager.hpp"
+#include "../src/ingest_queue.hpp"
+#include "../src/store.hpp"
+#include "../src/string_pool.hpp"
+#include "../src/kernels.hpp"
+#include "../src/csv.hpp"
 #include "../src/category.hpp"
 #include "../src/currency.hpp"
 #include "../src/fileio.hpp"
+#include "../src/journal.hpp"
+#include "../src/rate_history.hpp"
+#include "../src/timestamp.hpp"
 
 using namespace budget;
 
+Money money(double major) {
+    return Money::fromMajor(major);
+}
+
 void testBudgetManager() {
     std::cout << "Testing BudgetManager...\n";
     
     BudgetManager manager;
     
     // Test add entry
-    std::string id1 = manager.addEntry("Groceries", 50.0, Category::FOOD, Currency::GBP);
+    std::string id1 = manager.addEntry("Groceries", money(50.0), Category::FOOD, Currency::GBP);
     assert(manager.getEntryCount() == 1);
     std::cout << "  ✓ Add entry test passed\n";
     
     // Test add multiple entries
-    std::string id2 = manager.addEntry("Bus ticket", 2.5, Category::TRANSPORT, Currency::GBP);
-    std::string id3 = manager.addEntry("Rent", 800.0, Category::HOUSING, Currency::GBP);
+    std::string id2 = manager.addEntry("Bus ticket", money(2.5), Category::TRANSPORT, Currency::GBP);
+    std::string id3 = manager.addEntry("Rent", money(800.0), Category::HOUSING, Currency::GBP);
     assert(manager.getEntryCount() == 3);
     std::cout << "  ✓ Add multiple entries test passed\n";
     
     // Test modify entry
-    bool modified = manager.modifyEntry(id1, "Supermarket shopping", 60.0, Category::FOOD, Currency::GBP);
+    bool modified = manager.modifyEntry(id1, "Supermarket shopping", money(60.0), Category::FOOD, Currency::GBP);
     assert(modified == true);
     std::cout << "  ✓ Modify entry test passed\n";
     
@@ -42,9 +72,331 @@ void testBudgetManager() {
     std::cout << "  ✓ Get entries by category test passed\n";
     
     // Test get total by category
-    double total = manager.getTotalByCategory(Category::FOOD, Currency::GBP);
-    assert(total == 60.0);
+    Money total = manager.getTotalByCategory(Category::FOOD, Currency::GBP);
+    assert(total == money(60.0));
     std::cout << "  ✓ Get total by category test passed\n";
+    
+    // Test running totals stay in step with mutations
+    manager.addEntry("Flight", money(120.0), Category::TOURISM, Currency::USD);
+    manager.modifyEntry(id3, "Rent", money(850.0), Category::HOUSING, Currency::USD);
+    const CategoryTotals& totals = manager.getCategoryTotals();
+    assert(totals.getTotal(Category::HOUSING, Currency::GBP) == Money{});
+    assert(totals.getTotal(Category::HOUSING, Currency::USD) == money(850.0));
+    assert(totals.getCount(Category::TOURISM) == 1);
+    assert(totals.getCount(Category::TRANSPORT, Currency::GBP) == 0);
+    assert(totals.matches(manager.getEntries()));
+    
+    // Test ad-hoc totals over a filtered subset
+    CategoryTotals large = manager.computeCategoryTotals(
+        [](const EntryView& entry) { return entry.getAmount() > money(100.0); });
+    assert(large.getCount(Category::FOOD) == 0);
+    assert(large.getTotal(Category::TOURISM, Currency::USD) == money(120.0));
+    assert(large.getTotal(Category::HOUSING, Currency::USD) == money(850.0));
+    
+    manager.clear();
+    assert(manager.getCategoryTotals().getCount(Category::FOOD) == 0);
+    std::cout << "  ✓ Category totals test passed\n";
+}
+
+void testEntryStore() {
+    std::cout << "\nTesting EntryStore...\n";
+    
+    EntryStore store;
+    auto now = std::chrono::system_clock::now();
+    store.append(1, "Coffee", money(3.2), Category::FOOD, Currency::GBP, now);
+    store.append(2, "Train", money(12.0), Category::TRANSPORT, Currency::USD, now);
+    store.append(3, "Cinema", money(9.5), Category::ENTERTAINMENT, Currency::GBP, now);
+    assert(store.size() == 3);
+    assert(store.amounts()[1] == money(12.0));
+    assert(store.categories()[2] == Category::ENTERTAINMENT);
+    std::cout << "  ✓ Column access test passed\n";
+    
+    // Rewriting descriptions repeatedly must keep every row's text intact
+    for (int i = 0; i < 100; ++i) {
+        store.update(0, "Coffee and cake " + std::to_string(i), money(4.0), Category::FOOD, Currency::GBP);
+    }
+    store.erase(store.find(2));
+    assert(store.size() == 2);
+    assert(store[0].getDescription() == "Coffee and cake 99");
+    assert(store.find(2) == EntryStore::NPOS);
+    assert(store.find(3) == 2); // deletes leave other rows in place
+    assert(store[store.find(3)].getDescription() == "Cinema");
+    store.update(0, store[0].getDescription(), money(4.0), Category::FOOD, Currency::GBP); // view into the pool itself
+    assert(store[0].getDescription() == "Coffee and cake 99");
+    std::cout << "  ✓ Description pool test passed\n";
+    
+    // Deleting most rows sweeps the tombstones but keeps IDs resolvable
+    for (EntryId id = 4; id < 1004; ++id) {
+        store.append(id, "Bulk", money(1.0), Category::OTHER, Currency::GBP, now);
+    }
+    for (EntryId id = 4; id < 1004; ++id) {
+        if (id % 4 != 0) store.erase(store.find(id));
+    }
+    assert(store.size() == 252);
+    assert(store.rows() < 1003);
+    for (EntryId id = 4; id < 1004; id += 4) {
+        assert(store[store.find(id)].getId() == id);
+    }
+    assert(store[store.find(3)].getDescription() == "Cinema");
+    store.append(5000000, "Imported", money(7.0), Category::OTHER, Currency::GBP, now);
+    assert(store[store.find(5000000)].getAmount() == money(7.0));
+
+    // A high ID restored before the dense run it later falls inside (an unsorted file)
+    BudgetManager unsorted;
+    unsorted.restoreEntry(5000, "Early high ID", money(1.0), Category::OTHER, Currency::GBP, now);
+    for (EntryId id = 1; id < 5000; ++id) {
+        unsorted.restoreEntry(id, "Dense", money(1.0), Category::OTHER, Currency::GBP, now);
+    }
+    assert(unsorted.getEntries().contains(5000));
+    assert(unsorted.restoreEntry(5000, "Duplicate", money(1.0), Category::OTHER, Currency::GBP, now) == 5001);
+    assert(unsorted.deleteEntry("5000") && unsorted.getEntryCount() == 5000);
+    std::cout << "  ✓ ID index test passed\n";
+    
+    size_t rows = 0;
+    for (const auto& entry : store) {
+        assert(entry.getTimestamp() == now);
+        ++rows;
+    }
+    assert(rows == store.size());
+    std::cout << "  ✓ Row view iteration test passed\n";
+}
+
+void testStringPool() {
+    std::cout << "\nTesting StringPool...\n";
+    
+    StringPool pool;
+    auto food = pool.store("food_12.50_GBP");
+    auto again = pool.store(std::string("food_") + "12.50_GBP");
+    auto other = pool.store("transport_2.50_GBP");
+    assert(food == again && food != other);
+    assert(pool.store("") == StringPool::EMPTY && pool.view(StringPool::EMPTY).empty());
+    assert(pool.getStringCount() == 2);
+    pool.release(food);
+    assert(pool.view(again) == "food_12.50_GBP");
+    pool.release(again);
+    assert(pool.getStringCount() == 1);
+    std::cout << "  ✓ Interning test passed\n";
+    
+    // Churn enough bytes to force sweeps; surviving handles keep their text
+    std::vector<std::pair<StringPool::Handle, std::string>> kept;
+    for (int i = 0; i < 20000; ++i) {
+        std::string text = "description number " + std::to_string(i) + std::string(i % 50, 'x');
+        auto handle = pool.store(text);
+        if (i % 10 == 0) {
+            kept.emplace_back(handle, text);
+        } else {
+            pool.release(handle);
+        }
+    }
+    assert(pool.getArenaBytes() < 2 * pool.getLiveBytes() + (256 << 10));
+    StringPool copy = pool;
+    for (const auto& [handle, text] : kept) {
+        assert(pool.view(handle) == text && copy.view(handle) == text);
+        assert(pool.store(text) == handle);
+    }
+    assert(pool.view(other) == "transport_2.50_GBP");
+    pool.clear();
+    assert(pool.getStringCount() == 0 && pool.getArenaBytes() == 0);
+    assert(copy.getStringCount() == kept.size() + 1);
+    
+    StringPool plain;
+    plain.setInterning(false);
+    assert(plain.store("same") != plain.store("same"));
+    std::cout << "  ✓ Sweep and copy test passed\n";
+}
+
+void testHistogramKernel() {
+    std::cout << "\nTesting HistogramKernel (" << HistogramKernel::getIsaName() << ")...\n";
+    
+    // Odd length exercises the scalar tail after the vector blocks
+    std::vector<Money> amounts;
+    std::vector<Category> categories;
+    std::vector<Currency> currencies;
+    std::vector<std::uint8_t> selection;
+    for (size_t i = 0; i < 1001; ++i) {
+        amounts.push_back(Money::fromMinor(static_cast<std::int64_t>(i % 97) * 25 - 1000));
+        categories.push_back(i % 13 == 0 ? EntryStore::DEAD_CATEGORY
+                                         : static_cast<Category>(i % CATEGORY_COUNT));
+        currencies.push_back(static_cast<Currency>(i % CURRENCY_COUNT));
+        selection.push_back(i % 3 == 0 ? 0 : 1);
+    }
+    
+    for (bool masked : {false, true}) {
+        HistogramInput input{amounts, categories, currencies};
+        if (masked) input.selection = selection;
+        
+        CategoryAmounts expectedTotals{};
+        CategoryCounts expectedCounts{};
+        for (size_t i = 0; i < amounts.size(); ++i) {
+            auto c = static_cast<size_t>(categories[i]);
+            if (c >= CATEGORY_COUNT || (masked && selection[i] == 0)) continue;
+            expectedTotals[c][static_cast<size_t>(currencies[i])] += amounts[i];
+            ++expectedCounts[c][static_cast<size_t>(currencies[i])];
+        }
+        
+        CategoryAmounts totals{};
+        CategoryCounts counts{};
+        HistogramKernel::accumulate(input, totals, counts);
+        // Integer sums are exact, so any summation order agrees
+        assert(totals == expectedTotals);
+        assert(counts == expectedCounts);
+        
+        CategoryAmounts scalarTotals{};
+        CategoryCounts scalarCounts{};
+        HistogramKernel::accumulateScalar(input, scalarTotals, scalarCounts);
+        assert(scalarTotals == expectedTotals);
+        assert(scalarCounts == expectedCounts);
+    }
+    std::cout << "  ✓ Single-pass histogram test passed\n";
+}
+
+// Byte-at-a-time CSV state machine (the parser FileIO used before the block
+// scanner), kept as the oracle for the differential test below
+std::vector<std::vector<std::string>> parseCSVReference(std::string_view text) {
+    std::vector<std::vector<std::string>> records;
+    std::vector<std::string> fields;
+    std::string current;
+    bool inQuotes = false;
+    
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '"') {
+            if (inQuotes && i + 1 < text.size() && text[i + 1] == '"') {
+                current += '"';
+                ++i;
+            } else {
+                inQuotes = !inQuotes;
+            }
+        } else if ((c == ',' || c == '\n') && !inQuotes) {
+            fields.push_back(current);
+            current.clear();
+            if (c == '\n') {
+                records.push_back(fields);
+                fields.clear();
+            }
+        } else {
+            current += c;
+        }
+    }
+    if (!text.empty() && text.back() != '\n') {
+        fields.push_back(current);
+        records.push_back(fields);
+    }
+    return records;
+}
+
+void testCsvScanner() {
+    std::cout << "\nTesting CsvScanner (" << CsvScanner::getIsaName() << ")...\n";
+    
+    std::mt19937 rng(42);
+    const std::string alphabet = "ab ,\"\n";
+    for (int round = 0; round < 200; ++round) {
+        char block[CsvScanner::BLOCK_SIZE];
+        for (char& c : block) c = alphabet[rng() % alphabet.size()];
+        CsvBlockMasks expected = CsvScanner::classifyScalar(block);
+        CsvBlockMasks actual = CsvScanner::classify(block);
+        assert(actual.quotes == expected.quotes);
+        assert(actual.commas == expected.commas);
+        assert(actual.newlines == expected.newlines);
+        
+        uint64_t bits = (uint64_t{rng()} << 32) | rng();
+        assert(CsvScanner::prefixXor(bits) == CsvScanner::prefixXorScalar(bits));
+    }
+    std::cout << "  ✓ Block classification test passed\n";
+    
+    // Random well-formed CSV: plain fields, and quoted fields holding separators,
+    // line breaks and doubled quotes, long enough to straddle block boundaries
+    const std::string plain = "abcdefghij 0123456789.";
+    const std::string quoted = "xyz ,\n\"";
+    std::vector<std::string> originals;
+    for (int round = 0; round < 50; ++round) {
+        std::string text;
+        int records = 1 + static_cast<int>(rng() % 40);
+        for (int r = 0; r < records; ++r) {
+            int fields = 1 + static_cast<int>(rng() % 6);
+            for (int f = 0; f < fields; ++f) {
+                if (f > 0) text += ',';
+                std::string value;
+                size_t length = rng() % 90;
+                bool needsQuotes = rng() % 3 == 0;
+                for (size_t i = 0; i < length; ++i) {
+                    value += needsQuotes ? quoted[rng() % quoted.size()] : plain[rng() % plain.size()];
+                }
+                originals.push_back(value);
+                CsvEscaper::append(text, value);
+            }
+            if (r + 1 < records || rng() % 2 == 0) text += '\n';
+        }
+        
+        auto expected = parseCSVReference(text);
+        CsvReader reader(text);
+        size_t record = 0;
+        while (reader.next()) {
+            assert(record < expected.size());
+            auto fields = reader.fields();
+            assert(fields.size() == expected[record].size());
+            for (size_t f = 0; f < fields.size(); ++f) {
+                assert(fields[f] == expected[record][f]);
+            }
+            ++record;
+        }
+        assert(record == expected.size());
+    }
+    std::cout << "  ✓ Reader matches reference parser test passed\n";
+    
+    for (const auto& original : originals) {
+        if (original.empty()) continue;
+        std::string escaped = CsvEscaper::escape(original);
+        CsvReader reader(escaped);
+        assert(reader.next());
+        assert(reader.fields().size() == 1 && reader.fields()[0] == original);
+    }
+    assert(CsvEscaper::escape("plain text") == "plain text");
+    assert(CsvEscaper::escape("say \"hi\", ok") == "\"say \"\"hi\"\", ok\"");
+    std::cout << "  ✓ Escaper round trip test passed\n";
+}
+
+void testMoney() {
+    std::cout << "\nTesting Money...\n";
+    
+    // Decimal text is read exactly; a third decimal rounds half away from zero
+    assert(Money::parse("12") == Money::fromMinor(1200));
+    assert(Money::parse("-3.5") == Money::fromMinor(-350));
+    assert(Money::parse("0.07") == Money::fromMinor(7));
+    assert(Money::parse(".5") == Money::fromMinor(50));
+    assert(Money::parse("0.305") == Money::fromMinor(31));
+    assert(Money::parse("-0.305") == Money::fromMinor(-31));
+    assert(Money::parse("1e3") == Money::fromMinor(100000));
+    assert(!Money::parse("") && !Money::parse("-") && !Money::parse("--5") && !Money::parse("1.2x"));
+    assert(!Money::parse("abc") && !Money::parse("nan"));
+    // Largest amount that fits, and the first ones that overflow minor units
+    assert(Money::parse("92233720368547758.07") == Money::fromMinor(INT64_MAX));
+    assert(Money::parse("-92233720368547758.07") == Money::fromMinor(-INT64_MAX));
+    assert(!Money::parse("92233720368547758.08") && !Money::parse("100000000000000000"));
+    assert(!Money::parse("99999999999999999999") && !Money::parse("1e17") && !Money::parse("-1e300"));
+    assert(Money::fromMajor(1e300) == Money::fromMinor(INT64_MAX - 1023));
+    assert(Money::fromMajor(-INFINITY) == Money::fromMinor(-(INT64_MAX - 1023)));
+    assert(Money::fromMajor(NAN) == Money{} && Money::fromMinorRounded(NAN) == Money{});
+    assert(Money::fromMinorRounded(1e19) == Money::fromMinor(INT64_MAX - 1023));
+    std::cout << "  ✓ Parse test passed\n";
+    
+    assert(Money::fromMinor(-1205).toString() == "-12.05");
+    assert(Money::fromMinor(7).toString() == "0.07");
+    assert(Money::fromMinor(INT64_MIN).toString() == "-92233720368547758.08");
+    assert(Money::parse(Money::fromMinor(123456789).toString()) == Money::fromMinor(123456789));
+    std::cout << "  ✓ Format test passed\n";
+    
+    // A thousand tenths add up to exactly 100, unlike the same sum in doubles
+    Money sum;
+    for (int i = 0; i < 1000; ++i) sum += money(0.1);
+    assert(sum == money(100.0) && sum.toString() == "100.00");
+    CurrencyRates rates;
+    rates.setRate(Currency::USD, 1.27);
+    assert(rates.convert(money(10.0), Currency::GBP, Currency::USD) == money(12.7));
+    rates.setRate(Currency::USD, 3.0);
+    assert(rates.convert(money(1.0), Currency::USD, Currency::GBP) == Money::fromMinor(33));
+    assert(rates.convert(money(-1.0), Currency::USD, Currency::GBP) == Money::fromMinor(-33));
+    std::cout << "  ✓ Arithmetic test passed\n";
 }
 
 void testCurrencyConverter() {
@@ -59,12 +411,60 @@ void testCurrencyConverter() {
     assert(CurrencyConverter::fromString("GBP") == Currency::GBP);
     assert(CurrencyConverter::fromString("USD") == Currency::USD);
     assert(CurrencyConverter::fromString("gbp") == Currency::GBP);
+    assert(CurrencyConverter::fromString("Eur") == Currency::EUR);
+    assert(CurrencyConverter::tryFromString("jpy") == Currency::JPY);
+    assert(!CurrencyConverter::tryFromString("XYZ") && !CurrencyConverter::tryFromString("GB"));
+    for (auto currency : CurrencyConverter::getAllCurrencies()) {
+        assert(CurrencyConverter::fromString(CurrencyConverter::toString(currency)) == currency);
+    }
     std::cout << "  ✓ fromString test passed\n";
     
     // Test getSymbol
     assert(CurrencyConverter::getSymbol(Currency::GBP) == "£");
     assert(CurrencyConverter::getSymbol(Currency::USD) == "$");
+    assert(CurrencyConverter::getSymbol(Currency::EUR) == "€");
     std::cout << "  ✓ getSymbol test passed\n";
+    
+    // Cross rates come from the base quotes, and round trips come back to the penny
+    CurrencyRates rates;
+    rates.setRate(Currency::EUR, 1.2);
+    rates.setRate(Currency::JPY, 180.0);
+    assert(rates.getRate(Currency::GBP, Currency::EUR) == 1.2);
+    assert(std::abs(rates.getRate(Currency::EUR, Currency::JPY) - 150.0) < 1e-9);
+    assert(rates.convert(money(10.0), Currency::EUR, Currency::JPY) == money(1500.0));
+    assert(rates.convert(money(1500.0), Currency::JPY, Currency::EUR) == money(10.0));
+    bool threw = false;
+    try {
+        rates.setRate(Currency::GBP, 2.0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw && rates.getRate(Currency::GBP) == 1.0);
+    std::cout << "  ✓ Rate table test passed\n";
+    
+    // The batch kernel agrees with one-at-a-time conversion, also in place
+    std::vector<Money> column;
+    for (int i = -500; i < 500; ++i) column.push_back(Money::fromMinor(i * 37));
+    std::vector<Money> converted(column.size());
+    rates.convert(column, converted, Currency::CHF, Currency::INR);
+    for (std::size_t i = 0; i < column.size(); ++i) {
+        assert(converted[i] == rates.convert(column[i], Currency::CHF, Currency::INR));
+    }
+    rates.convert(column, column, Currency::CHF, Currency::INR);
+    assert(column == converted);
+    
+    // Totals in every currency report as one, converted per currency bin
+    CategoryTotals totals;
+    totals.add(Category::FOOD, Currency::GBP, money(10.0));
+    totals.add(Category::FOOD, Currency::EUR, money(12.0));
+    totals.add(Category::FOOD, Currency::JPY, money(1800.0));
+    totals.add(Category::HOUSING, Currency::EUR, money(600.0));
+    auto inGbp = totals.getTotalsIn(rates, Currency::GBP);
+    assert(inGbp[static_cast<std::size_t>(Category::FOOD)] == money(30.0));
+    assert(inGbp[static_cast<std::size_t>(Category::HOUSING)] == money(500.0));
+    assert(inGbp[static_cast<std::size_t>(Category::OTHER)] == Money{});
+    assert(totals.getTotalsIn(rates, Currency::EUR)[static_cast<std::size_t>(Category::FOOD)] == money(36.0));
+    std::cout << "  ✓ Batch conversion test passed\n";
 }
 
 void testCategoryManager() {
@@ -79,20 +479,420 @@ void testCategoryManager() {
     assert(CategoryManager::fromString("Food") == Category::FOOD);
     assert(CategoryManager::fromString("food") == Category::FOOD);
     assert(CategoryManager::fromString("Transport") == Category::TRANSPORT);
+    assert(CategoryManager::fromString("SUBSCRIPTIONS") == Category::SUBSCRIPTIONS);
+    assert(CategoryManager::fromString("kItTeNs") == Category::KITTENS);
+    for (std::string_view bad : {"", "Foo", "Foods", "Other ", "Kittens\n", "GBP"}) {
+        assert(!CategoryManager::tryFromString(bad));
+    }
     std::cout << "  ✓ fromString test passed\n";
     
     // Test getAllCategories
     auto categories = CategoryManager::getAllCategories();
     assert(categories.size() == 9);
+    for (std::size_t i = 0; i < categories.size(); ++i) {
+        assert(static_cast<std::size_t>(categories[i]) == i);
+        assert(CategoryManager::fromString(CategoryManager::toString(categories[i])) == categories[i]);
+    }
+    bool threw = false;
+    try {
+        CategoryManager::toString(static_cast<Category>(CATEGORY_COUNT));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
     std::cout << "  ✓ getAllCategories test passed\n";
 }
 
+void testBulkMutations() {
+    std::cout << "Testing bulk mutations...\n";
+
+    BudgetManager manager;
+    std::vector<NewEntry> batch;
+    for (int i = 0; i < 300; ++i) {
+        batch.push_back(NewEntry{i % 3 == 0 ? "Netflix" : "Tesco " + std::to_string(i), money(10.0),
+                                 i % 3 == 0 ? Category::ENTERTAINMENT : Category::GROCERY,
+                                 i % 2 ? Currency::GBP : Currency::EUR});
+    }
+    assert(manager.addEntries(batch) == 1);
+    assert(manager.getEntries().capacity() >= 300);
+    manager.deleteEntry("2"); // leaves a tombstone for deleteWhere to sweep
+    manager.getTotalsForMonth(std::chrono::year_month{std::chrono::year{2020}, std::chrono::January});
+
+    size_t changed = manager.modifyWhere(
+        [](const EntryView& entry) { return entry.getDescription() == "Netflix"; },
+        [](EntryChange& change) { change.category = Category::SUBSCRIPTIONS; });
+    assert(changed == 100);
+    assert(manager.getCategoryTotals().getCount(Category::ENTERTAINMENT) == 0);
+    assert(manager.getCategoryTotals().getCount(Category::SUBSCRIPTIONS) == 100);
+    assert(manager.getTotalByCategory(Category::SUBSCRIPTIONS, Currency::EUR) == money(500.0));
+
+    // Rows the mutation leaves as they were are not counted
+    assert(manager.modifyWhere([](const EntryView&) { return true; },
+                               [](EntryChange& change) { change.category = Category::SUBSCRIPTIONS; }) == 199);
+    assert(manager.modifyWhere([](const EntryView& entry) { return entry.getId() <= 10; },
+                               [](EntryChange& change) { change.description = "Groceries"; }) == 9);
+    assert(manager.getEntries()[manager.getEntries().find(4)].getDescription() == "Groceries");
+
+    assert(manager.deleteWhere([](const EntryView& entry) { return entry.getCurrency() == Currency::EUR; }) == 150);
+    assert(manager.getEntryCount() == 149);
+    assert(manager.getEntries().rows() == 149); // the earlier tombstone is gone too
+    assert(manager.getEntries().find(3) == EntryStore::NPOS && manager.getEntries().find(4) != EntryStore::NPOS);
+    for (const auto& entry : manager.getEntries()) {
+        assert(manager.getEntries().find(entry.getId()) == entry.getRow());
+    }
+    assert(manager.getCategoryTotals().matches(manager.getEntries()));
+    using namespace std::chrono;
+    assert(manager.getTotalsBetween(year{2020} / 1 / 1, year{2100} / 1 / 1).getCount(Category::SUBSCRIPTIONS) == 149);
+    assert(manager.deleteWhere([](const EntryView&) { return false; }) == 0);
+    std::cout << "  ✓ Bulk add, modifyWhere and deleteWhere test passed\n";
+}
+
+void testBatchRunner() {
+    std::cout << "Testing BatchRunner...\n";
+
+    auto words = BatchRunner::splitWords(R"(add 12.50 food gbp "Fish ""n"" chips"  # lunch)");
+    assert(words && (*words == std::vector<std::string>{"add", "12.50", "food", "gbp", "Fish \"n\" chips"}));
+    assert(!BatchRunner::splitWords("add 1 Food GBP \"open"));
+    assert(BatchRunner::splitWords("   # only a comment")->empty());
+    std::cout << "  ✓ Command splitting test passed\n";
+
+    BudgetManager manager;
+    std::ostringstream out;
+    BatchRunner runner(manager, out);
+    std::istringstream commands(
+        "add 12.50 Food GBP Lunch\n"
+        "add 40 Transport EUR \"Train, return\"\n"
+        "\n"
+        "modify 2 30 Transport EUR Train\n"
+        "rate EUR 1.25\n"
+        "income 1000 500\n"
+        "summary GBP\n"
+        "delete 7\n"
+        "add ten Food GBP\n"
+        "frobnicate\n"
+        "save test_batch.csv\n"
+        "clear\n"
+        "load test_batch.csv\n"
+        "count\n");
+    assert(runner.run(commands) == 3);
+    runner.finish();
+
+    std::vector<std::string> lines;
+    std::istringstream output(out.str());
+    for (std::string line; std::getline(output, line);) lines.push_back(line);
+    assert(lines.size() == 14);
+    assert(lines[0].starts_with(R"({"line":1,"command":"add","ok":true,"id":1,"ms":)"));
+    assert(lines[1].starts_with(R"({"line":2,"command":"add","ok":true,"id":2,)"));
+    assert(lines[5].find(R"("categories":{"Food":12.50,"Transport":24.00},"spent":36.50,"income":1500.00)") !=
+           std::string::npos);
+    assert(lines[6].find(R"("ok":false,"error":"no entry with ID 7")") != std::string::npos);
+    assert(lines[7].find(R"("error":"invalid amount: ten")") != std::string::npos);
+    assert(lines[8].find(R"("error":"unknown command")") != std::string::npos);
+    assert(lines[12].find(R"("command":"count","ok":true,"entries":2,)") != std::string::npos);
+    assert(lines[13].starts_with(R"({"done":true,"commands":13,"failed":3,"entries":2,"ms":)"));
+    assert(manager.getTotalByCategory(Category::TRANSPORT, Currency::EUR) == money(30.0));
+    std::filesystem::remove("test_batch.csv");
+
+    // argv-style: one command per call
+    std::vector<std::string> add = {"add", "5", "Kittens", "USD", "Cat", "food"};
+    assert(runner.run(add));
+    assert(manager.getEntries()[manager.getEntries().find(3)].getDescription() == "Cat food");
+    assert(BatchRunner::isCommand("summary") && !BatchRunner::isCommand("batch"));
+    std::cout << "  ✓ Batch run test passed\n";
+}
+
+void testQuery() {
+    std::cout << "Testing Query...\n";
+
+    using namespace std::chrono;
+    const std::array<std::string, 4> shops = {"Tesco Metro", "NETFLIX.com", "Pret A Manger", "Tesco Extra"};
+    std::mt19937 random(7);
+    auto start = sys_days{year{2024} / 1 / 1};
+
+    // Same entries twice: once in time order, once shuffled so the binary search cannot be used
+    std::vector<NewEntry> batch;
+    for (int i = 0; i < 2000; ++i) {
+        batch.push_back(NewEntry{shops[random() % shops.size()], Money::fromMinor(100 + random() % 20000),
+                                 static_cast<Category>(random() % CATEGORY_COUNT),
+                                 random() % 4 ? Currency::GBP : Currency::USD, start + hours{3 * i}});
+    }
+    BudgetManager ordered;
+    ordered.addEntries(batch);
+    ordered.deleteEntry("10");
+    std::shuffle(batch.begin(), batch.end(), random);
+    BudgetManager shuffled;
+    shuffled.addEntries(batch);
+    assert(ordered.getEntries().isTimeOrdered() && !shuffled.getEntries().isTimeOrdered());
+
+    auto first = start + days{30};
+    auto until = start + days{60};
+    auto matches = [&](const EntryView& entry) {
+        std::string description(entry.getDescription());
+        return (entry.getCategory() == Category::FOOD || entry.getCategory() == Category::GROCERY) &&
+               entry.getCurrency() == Currency::GBP && entry.getAmount() >= money(20.0) &&
+               entry.getAmount() <= money(150.0) && entry.getTimestamp() >= first && entry.getTimestamp() < until &&
+               description.starts_with("Tesco");
+    };
+    size_t expected = 0;
+    for (const auto& entry : ordered.getEntries()) expected += matches(entry) ? 1 : 0;
+    assert(expected > 0);
+
+    for (const BudgetManager* manager : {&ordered, &shuffled}) {
+        Query query = Query(*manager)
+                          .inCategories({Category::FOOD, Category::GROCERY, Category::HOUSING})
+                          .inCategories({Category::FOOD, Category::GROCERY})
+                          .inCurrency(Currency::GBP)
+                          .amountBetween(money(20.0), money(150.0))
+                          .between(first, until)
+                          .descriptionContains("tesco");
+        assert(query.count() == expected);
+        for (EntryView entry : query.entries()) assert(matches(entry));
+
+        CategoryTotals totals = query.totals();
+        assert(totals.getCount(Category::FOOD) + totals.getCount(Category::GROCERY) == expected);
+        assert(query.total() == totals.getTotal(Category::FOOD, Currency::GBP) +
+                                    totals.getTotal(Category::GROCERY, Currency::GBP));
+
+        auto top = query.top(5);
+        assert(top.size() == 5);
+        for (size_t i = 1; i < top.size(); ++i) assert(top[i - 1].getAmount() >= top[i].getAmount());
+        for (EntryView entry : query.entries()) assert(entry.getAmount() <= top[0].getAmount());
+        assert(query.top(expected + 10).size() == expected);
+
+        auto page0 = query.page(0, 7);
+        auto page1 = query.page(1, 7);
+        auto all = query.page(0, expected);
+        assert(page0.size() == 7 && page1.size() == 7 && all.size() == expected);
+        assert(page1[0].getRow() == all[7].getRow());
+        assert(query.page(expected / 7 + 1, 7).empty());
+    }
+
+    // Category/currency-only aggregates come from the running totals
+    Query food = Query(ordered).inCategory(Category::FOOD).inCurrency(Currency::USD);
+    assert(food.count() == ordered.getCategoryTotals().getCount(Category::FOOD, Currency::USD));
+    assert(food.totals().getTotal(Category::FOOD, Currency::USD) ==
+           ordered.getTotalByCategory(Category::FOOD, Currency::USD));
+    assert(Query(ordered).count() == ordered.getEntryCount());
+    assert(Query(ordered).inCategory(Category::FOOD).inCategory(Category::OTHER).count() == 0);
+    assert(std::ranges::distance(Query(ordered).inCategory(Category::FOOD).inCategory(Category::OTHER).rows()) == 0);
+    assert(Query(ordered).descriptionContains("tesco").descriptionContains("metro").count() ==
+           Query(ordered).descriptionContains("TESCO METRO").count());
+
+    // Local dates, matching the time index
+    auto day = year_month_day{year{2024} / 1 / 20};
+    CategoryTotals byIndex = ordered.getTotalsBetween(day, day);
+    size_t onDay = 0;
+    for (Category category : CategoryManager::getAllCategories()) onDay += byIndex.getCount(category);
+    assert(onDay == 8 && Query(ordered).onDates(day, day).count() == onDay);
+
+    // Views share the needles rather than copying them, and outlive the Query
+    Query tesco = Query(ordered).descriptionContains("tesco");
+    Query metro = tesco;
+    metro.descriptionContains("metro");
+    assert(metro.count() < tesco.count() && tesco.count() == Query(ordered).descriptionContains("TESCO").count());
+    auto detached = Query(ordered).descriptionContains("netflix").entries();
+    assert(std::ranges::distance(detached) > 0);
+    for (EntryView entry : detached) assert(entry.getDescription() == "NETFLIX.com");
+    std::cout << "  ✓ Query filters, aggregates, top-N and pages test passed\n";
+}
+
+void testSortedViews() {
+    std::cout << "Testing SortedView...\n";
+
+    using namespace std::chrono;
+    std::mt19937 random(11);
+
+    // Enough items to split blocks, with duplicate keys straddling them
+    SortedView view;
+    std::vector<SortedView::Item> items;
+    for (EntryId id = 1; id <= 5000; ++id) {
+        items.push_back({static_cast<std::int64_t>(random() % 700), id});
+        view.insert(items.back());
+    }
+    for (size_t i = 0; i < items.size(); i += 3) assert(view.erase(items[i]));
+    assert(!view.erase(items[0]) && !view.erase({items[1].key + 1, items[1].id}));
+    std::erase_if(items, [&](const SortedView::Item& item) { return (item.id - 1) % 3 == 0; });
+    auto ordered = [](std::vector<SortedView::Item> expected) {
+        std::ranges::sort(expected, [](const SortedView::Item& a, const SortedView::Item& b) {
+            return a.key < b.key || (a.key == b.key && a.id > b.id);
+        });
+        return expected;
+    };
+    auto expected = ordered(items);
+    assert(view.size() == expected.size());
+    assert(std::ranges::equal(view.ascending(), expected));
+    assert(std::ranges::equal(view.descending(), expected | std::views::reverse));
+    SortedView rebuilt;
+    rebuilt.assign(items);
+    assert(std::ranges::equal(rebuilt.ascending(), expected));
+    for (std::int64_t key : {-1, 0, 1, 350, 698, 699, 700}) {
+        auto it = std::ranges::lower_bound(expected, key, {}, &SortedView::Item::key);
+        const SortedView::Item* found = view.lowerBound(key);
+        assert(it == expected.end() ? found == nullptr : found && *found == *it);
+    }
+
+    // The manager keeps both orders in step through every kind of mutation
+    auto start = sys_days{year{2024} / 1 / 1};
+    BudgetManager manager;
+    manager.setRate(Currency::USD, 1.25);
+    assert(manager.getSortedView(SortKey::AMOUNT) == nullptr);
+    for (int i = 0; i < 3000; ++i) {
+        manager.restoreEntry(0, "Entry", Money::fromMinor(100 + random() % 9000),
+                             static_cast<Category>(random() % CATEGORY_COUNT),
+                             random() % 3 ? Currency::GBP : Currency::USD, start + minutes{random() % 500000});
+    }
+    manager.enableSortedViews();
+    // Rows loaded after enabling but before the first query land in the one sort
+    for (int i = 0; i < 500; ++i) {
+        manager.restoreEntry(0, "Loaded", Money::fromMinor(100 + random() % 9000), Category::FOOD, Currency::USD,
+                             start + minutes{random() % 500000});
+    }
+    auto check = [&] {
+        for (size_t k = 0; k < SORT_KEY_COUNT; ++k) {
+            std::vector<SortedView::Item> all;
+            for (const auto& entry : manager.getEntries()) {
+                std::int64_t key = k == static_cast<size_t>(SortKey::AMOUNT)
+                                       ? manager.getRates().convert(entry.getAmount(), entry.getCurrency(),
+                                                                    BASE_CURRENCY).getMinor()
+                                       : duration_cast<nanoseconds>(entry.getTimestamp().time_since_epoch()).count();
+                all.push_back({key, entry.getId()});
+            }
+            assert(std::ranges::equal(manager.getSortedView(static_cast<SortKey>(k))->ascending(), ordered(all)));
+        }
+        assert(manager.getCategoryTotals().matches(manager.getEntries()));
+    };
+    check();
+    manager.addEntry("Sofa", money(899.0), Category::HOUSING, Currency::USD);
+    manager.modifyEntry("5", "Bigger", money(950.0), Category::OTHER, Currency::GBP);
+    manager.deleteEntry("6");
+    manager.modifyWhere([](const EntryView& entry) { return entry.getCategory() == Category::FOOD; },
+                        [](EntryChange& change) { change.amount = change.amount + money(1.0); });
+    manager.deleteWhere([](const EntryView& entry) { return entry.getCategory() == Category::HOUSING; });
+    std::vector<NewEntry> batch(10, NewEntry{"Bulk", money(3.0), Category::GROCERY, Currency::USD, start});
+    manager.addEntries(batch);
+    manager.setRate(Currency::USD, 1.5);
+    check();
+
+    // Queries through the orders agree with the scans over a copy without them
+    BudgetManager plain;
+    for (const auto& entry : manager.getEntries()) {
+        plain.restoreEntry(entry.getId(), entry.getDescription(), entry.getAmount(), entry.getCategory(),
+                           entry.getCurrency(), entry.getTimestamp());
+    }
+    plain.setRate(Currency::USD, 1.5);
+    auto rows = [](const std::vector<EntryView>& entries) {
+        std::vector<EntryId> ids;
+        for (EntryView entry : entries) ids.push_back(entry.getId());
+        return ids;
+    };
+    auto month = [](const BudgetManager& m) {
+        return Query(m).onDates(year{2024} / 3 / 1, year{2024} / 3 / 31);
+    };
+    assert(rows(Query(manager).top(20)) == rows(Query(plain).top(20)));
+    assert(rows(month(manager).top(20)) == rows(month(plain).top(20)));
+    assert(rows(month(manager).inCategory(Category::FOOD).top(20)) ==
+           rows(month(plain).inCategory(Category::FOOD).top(20)));
+    assert(rows(month(manager).latest(15)) == rows(month(plain).latest(15)));
+    assert(rows(Query(manager).top(20, Currency::USD)) == rows(Query(plain).top(20, Currency::USD)));
+
+    auto top = month(manager).top(20);
+    assert(top.size() == 20);
+    for (size_t i = 1; i < top.size(); ++i) {
+        assert(manager.getRates().convert(top[i - 1].getAmount(), top[i - 1].getCurrency(), BASE_CURRENCY) >=
+               manager.getRates().convert(top[i].getAmount(), top[i].getCurrency(), BASE_CURRENCY));
+    }
+    auto latest = Query(manager).latest(10);
+    for (size_t i = 1; i < latest.size(); ++i) assert(latest[i - 1].getTimestamp() >= latest[i].getTimestamp());
+    assert(latest[0].getTimestamp() == manager.getEntries().timestamps()[
+           static_cast<size_t>(std::ranges::max_element(manager.getEntries().timestamps()) -
+                               manager.getEntries().timestamps().begin())]);
+
+    auto perCategory = Query(manager).topByCategory(3);
+    for (Category category : CategoryManager::getAllCategories()) {
+        assert(rows(perCategory[static_cast<size_t>(category)]) == rows(Query(plain).inCategory(category).top(3)));
+    }
+    assert(perCategory[static_cast<size_t>(Category::HOUSING)].empty());
+
+    manager.clear();
+    assert(manager.getSortedView(SortKey::AMOUNT)->empty() && Query(manager).top(5).empty());
+    std::cout << "  ✓ SortedView order maintenance and top-N test passed\n";
+}
+
+void testEntryPager() {
+    std::cout << "Testing EntryPager...\n";
+
+    using namespace std::chrono;
+    auto start = sys_days{year{2024} / 5 / 1} + hours{12};
+    BudgetManager manager;
+    for (int i = 0; i < 25; ++i) {
+        manager.restoreEntry(0, i == 2 ? "Café crème at the station kiosk" : "Item " + std::to_string(i),
+                             Money::fromMinor(1050 + i), Category::FOOD, Currency::EUR, start + days{i});
+    }
+    manager.deleteEntry("4");
+    manager.deleteEntry("5");
+
+    EntryPager pager(manager, PagerOptions{10, 80, false});
+    auto lines = [](std::string_view page) {
+        std::vector<std::string> result;
+        for (auto line : page | std::views::split('\n')) result.emplace_back(line.begin(), line.end());
+        result.pop_back(); // after the final newline
+        return result;
+    };
+    std::string page(pager.page());
+    auto first = lines(page);
+    assert(first.size() == 13); // header, rule, 10 rows, position
+    assert(first[0].starts_with("ID          Description") && first[0].find("\033") == std::string::npos);
+    assert(first[1] == std::string(80, '-'));
+    assert(first[2] == "1           Item 0                              10.50  Food           EUR       ");
+    // Truncated to the column, by characters rather than bytes
+    assert(first[4].starts_with("3           Café crème at the station kio       10.52"));
+    assert(first[5].starts_with("6 ") && first.back() == "Entries 1-10 of 23");
+
+    assert(pager.next() && lines(pager.page()).back() == "Entries 11-20 of 23");
+    assert(pager.next() && lines(pager.page()).back() == "Entries 21-23 of 23");
+    assert(!pager.next() && pager.previous() && pager.getPosition() == 10);
+    pager.first();
+    assert(!pager.previous() && std::string(pager.page()) == page);
+    pager.last();
+    assert(lines(pager.page()).back() == "Entries 14-23 of 23");
+
+    assert(pager.jumpToId(17) && lines(pager.page())[2].starts_with("17 "));
+    assert(!pager.jumpToId(4) && !pager.jumpToId(99) && pager.getPosition() == 14);
+
+    // Jump to date through each index: time-ordered rows, the sorted time view, a scan
+    BudgetManager shuffled;
+    for (int i : {7, 3, 11, 0, 9}) {
+        shuffled.restoreEntry(0, "Day " + std::to_string(i), money(1.0), Category::OTHER, Currency::GBP,
+                              start + days{i});
+    }
+    BudgetManager indexed = shuffled;
+    indexed.enableSortedViews();
+    for (const BudgetManager* m : {&manager, &shuffled, &indexed}) {
+        EntryPager dated(*m, PagerOptions{3, 80, false});
+        assert(dated.jumpToDate(start - hours{12} + days{3}));
+        // Items 3 and 4 were deleted, so the ledger in time order lands on the next live entry
+        assert(lines(dated.page())[2].find(m == &manager ? "Item 5" : "Day 3") != std::string::npos);
+        assert(!dated.jumpToDate(start + days{30}));
+    }
+
+    // Colour and width are applied from the options
+    EntryPager wide(manager, PagerOptions{5, 200, true});
+    auto coloured = lines(wide.page());
+    assert(coloured[0].starts_with("\033[1mID") && coloured.back() == "\033[1mEntries 1-5 of 23\033[0m");
+    assert(coloured[1].size() == 12 + 60 + 10 + 2 + 15 + 10);
+
+    BudgetManager empty;
+    EntryPager none(empty);
+    assert(lines(none.page()).back() == "\033[1mNo entries\033[0m" && !none.next());
+    std::cout << "  ✓ EntryPager pages, jumps and layout test passed\n";
+}
+
 void testFileIO() {
     std::cout << "\nTesting FileIO...\n";
     
     BudgetManager manager;
-    manager.addEntry("Test entry 1", 100.0, Category::FOOD, Currency::GBP);
-    manager.addEntry("Test entry 2", 50.0, Category::TRANSPORT, Currency::USD);
+    manager.addEntry("Test entry 1", money(100.0), Category::FOOD, Currency::GBP);
+    manager.addEntry("Test entry 2", money(50.0), Category::TRANSPORT, Currency::USD);
     
     // Test save - use relative path that works on all platforms
     std::string testFile = "test_budget.csv";
@@ -106,16 +906,833 @@ void testFileIO() {
     assert(loaded == true);
     assert(loadedManager.getEntryCount() == 2);
     std::cout << "  ✓ Load budget test passed\n";
+    
+    // Test IDs, timestamps, metadata and awkward descriptions survive a round trip
+    BudgetManager source;
+    source.setExchangeRate(1.25);
+    source.setRate(Currency::EUR, 1.1875);
+    source.setBabuIncome(money(5000.0));
+    source.addEntry("Dinner, drinks", money(42.5), Category::FOOD, Currency::GBP);
+    std::string gone = source.addEntry("Deleted", money(1.0), Category::OTHER, Currency::GBP);
+    source.addEntry("The \"best\" pizza\nand more", money(18.0), Category::FOOD, Currency::USD);
+    source.deleteEntry(gone);
+    assert(FileIO::saveBudget(source, testFile));
+    
+    BudgetManager restored;
+    assert(FileIO::loadBudget(restored, testFile));
+    assert(restored.getEntryCount() == 2);
+    assert(restored.getExchangeRate() == 1.25);
+    assert(restored.getRate(Currency::EUR) == 1.1875);
+    assert(restored.getRate(Currency::JPY) == BudgetManager().getRate(Currency::JPY));
+    assert(restored.getBabuIncome() == money(5000.0));
+    auto original = source.getEntries().begin();
+    for (const auto& entry : restored.getEntries()) {
+        const auto& expected = *original++;
+        assert(entry.getId() == expected.getId());
+        assert(entry.getDescription() == expected.getDescription());
+        assert(entry.getAmount() == expected.getAmount());
+        assert(entry.getCategory() == expected.getCategory());
+        assert(entry.getCurrency() == expected.getCurrency());
+        assert(entry.getTimestamp() ==
+               std::chrono::floor<std::chrono::seconds>(expected.getTimestamp()));
+    }
+    assert(restored.addEntry("Next", money(1.0), Category::OTHER, Currency::GBP) == "4");
+    
+    // Amounts survive exactly, to the penny, however large
+    BudgetManager precise;
+    precise.addEntry("Awkward", money(0.1 + 0.2), Category::FOOD, Currency::GBP);
+    precise.addEntry("Large", Money::fromMinor(123456789012345), Category::HOUSING, Currency::USD);
+    precise.addEntry("Refund", money(-0.05), Category::HOUSING, Currency::USD);
+    assert(FileIO::saveBudget(precise, testFile));
+    assert(FileIO::loadBudget(restored, testFile));
+    assert(restored.getTotalByCategory(Category::FOOD, Currency::GBP) == Money::fromMinor(30));
+    assert(restored.getTotalByCategory(Category::HOUSING, Currency::USD) == Money::fromMinor(123456789012340));
+
+    // An ID with trailing junk is not a number; the entry gets a fresh ID, not its leading digits
+    {
+        std::ofstream malformed(testFile, std::ios::trunc);
+        malformed << "ID,Description,Amount,Category,Currency,Timestamp\n"
+                  << "7000abc,Malformed,2.50,Other,GBP,2024-01-01 12:00:00\n";
+    }
+    assert(FileIO::loadBudget(restored, testFile));
+    assert(restored.getEntryCount() == 1 && (*restored.getEntries().begin()).getId() == 1);
+    std::cout << "  ✓ Round trip test passed\n";
+    
+    // The cached formatter agrees with put_time/localtime on every day of two
+    // years, including DST transitions, and the parser reads its output back
+    TimestampFormatter formatter;
+    TimestampParser parser;
+    auto start = std::chrono::sys_days{std::chrono::year{2023} / 1 / 1};
+    for (std::chrono::seconds t{0}; t < std::chrono::days{730}; t += std::chrono::seconds{2400 + 7}) {
+        std::chrono::system_clock::time_point point = start + t;
+        std::time_t time = std::chrono::system_clock::to_time_t(point);
+        std::ostringstream reference;
+        reference << std::put_time(std::localtime(&time), "%Y-%m-%d %H:%M:%S");
+        std::string formatted(formatter.format(point));
+        assert(formatted == reference.str());
+        auto parsed = parser.parse(formatted);
+        assert(parsed && formatter.format(*parsed) == formatted);
+    }
+    std::cout << "  ✓ Timestamp formatter test passed\n";
+    
+    // Test a parallel load matches the serial one row for row, including quoted
+    // newlines that straddle chunk cuts and IDs that clash and must be reassigned
+    BudgetManager large;
+    large.setMamuIncome(money(2800.0));
+    for (int i = 0; i < 3000; ++i) {
+        std::string description = i % 7 == 0 ? "Multi\nline, \"quoted\" " + std::to_string(i)
+                                             : "Entry " + std::to_string(i);
+        large.addEntry(description, money(i * 0.5), static_cast<Category>(i % CATEGORY_COUNT),
+                       static_cast<Currency>(i % CURRENCY_COUNT));
+    }
+    assert(FileIO::saveBudget(large, testFile));
+    {
+        std::ofstream append(testFile, std::ios::app);
+        append << "1,Clashing ID,9.99,Other,GBP,2024-01-01 12:00:00\n";
+        append << "x,Bad ID,1.00,Other,GBP,not a timestamp\n";
+    }
+    
+    BudgetManager serial;
+    assert(FileIO::loadBudget(serial, testFile));
+    for (unsigned threads : {2u, 3u, 8u}) {
+        BudgetManager parallel;
+        LoadStats stats;
+        assert(FileIO::loadBudget(parallel, testFile,
+                                  LoadOptions{.threads = threads, .minChunkBytes = 1024, .stats = &stats}));
+        assert(stats.chunks > 1 && stats.entries == 3002);
+        assert(parallel.getMamuIncome() == money(2800.0));
+        assert(parallel.getEntryCount() == serial.getEntryCount());
+        auto expected = serial.getEntries().begin();
+        for (const auto& entry : parallel.getEntries()) {
+            const auto& other = *expected++;
+            assert(entry.getId() == other.getId());
+            assert(entry.getDescription() == other.getDescription());
+            assert(entry.getAmount() == other.getAmount());
+        }
+    }
+    std::cout << "  ✓ Parallel load test passed\n";
+}
+
+void testTimeIndex() {
+    std::cout << "\nTesting TimeIndex...\n";
+    
+    using namespace std::chrono;
+    BudgetManager manager;
+    std::mt19937 random(7);
+    auto start = sys_days{year{2022} / 11 / 20};
+    for (int i = 0; i < 2000; ++i) {
+        auto timestamp = system_clock::time_point(start + hours{random() % (24 * 500)});
+        manager.restoreEntry(0, "Entry", Money::fromMinor(random() % 100000),
+                             static_cast<Category>(random() % CATEGORY_COUNT),
+                             static_cast<Currency>(random() % CURRENCY_COUNT), timestamp);
+    }
+    
+    // Brute-force reference: filter on the local date of each entry
+    auto localDate = [](system_clock::time_point timestamp) {
+        std::time_t time = system_clock::to_time_t(timestamp);
+        std::tm local = *std::localtime(&time);
+        return year_month_day{year{local.tm_year + 1900}, month{static_cast<unsigned>(local.tm_mon + 1)},
+                              day{static_cast<unsigned>(local.tm_mday)}};
+    };
+    auto check = [&](year_month_day first, year_month_day last) {
+        CategoryTotals fast = manager.getTotalsBetween(first, last);
+        CategoryTotals slow = manager.computeCategoryTotals([&](const EntryView& entry) {
+            auto date = localDate(entry.getTimestamp());
+            return date >= first && date <= last;
+        });
+        for (auto category : CategoryManager::getAllCategories()) {
+            for (auto currency : CurrencyConverter::getAllCurrencies()) {
+                assert(fast.getCount(category, currency) == slow.getCount(category, currency));
+                assert(fast.getTotal(category, currency) == slow.getTotal(category, currency));
+            }
+        }
+    };
+    
+    for (int i = 0; i < 50; ++i) {
+        auto first = year_month_day{start + days{random() % 520} - days{10}};
+        check(first, year_month_day{sys_days{first} + days{random() % 200}});
+    }
+    check(year_month_day{year{2020} / 1 / 1}, year_month_day{year{2030} / 1 / 1});
+    check(year_month_day{year{2023} / 5 / 1}, year_month_day{year{2023} / 4 / 1}); // empty range
+    std::cout << "  ✓ Date range totals test passed\n";
+    
+    // The index follows mutations made after it was built
+    manager.restoreEntry(0, "Far future", money(12.5), Category::KITTENS, Currency::GBP,
+                         system_clock::time_point(sys_days{year{2031} / 6 / 15} + hours{12}));
+    manager.restoreEntry(0, "Far past", money(7.25), Category::FOOD, Currency::USD,
+                         system_clock::time_point(sys_days{year{2019} / 2 / 3} + hours{12}));
+    for (int id = 1; id <= 300; id += 2) manager.deleteEntry(std::to_string(id));
+    for (int id = 2; id <= 300; id += 6) manager.modifyEntry(std::to_string(id), "Changed", money(3.0), Category::OTHER, Currency::GBP);
+    check(year_month_day{year{2019} / 1 / 1}, year_month_day{year{2031} / 12 / 31});
+    check(year_month_day{year{2023} / 1 / 1}, year_month_day{year{2023} / 3 / 31});
+    assert(manager.getTotalsForMonth(year{2031} / 6).getTotal(Category::KITTENS, Currency::GBP) == money(12.5));
+    
+    // Monthly rollups cover every month in order and add up to the overall totals
+    auto months = manager.getMonthlyTotals();
+    assert(months.front().month == year{2019} / 2 && months.back().month == year{2031} / 6);
+    assert(months.size() == static_cast<std::size_t>((2031 - 2019) * 12 + 5));
+    CategoryTotals sum;
+    for (const auto& month : months) sum.merge(month.totals);
+    for (auto category : CategoryManager::getAllCategories()) {
+        assert(sum.getCount(category, Currency::GBP) == manager.getCategoryTotals().getCount(category, Currency::GBP));
+        assert(sum.getTotal(category, Currency::USD) == manager.getCategoryTotals().getTotal(category, Currency::USD));
+    }
+    std::cout << "  ✓ Monthly rollup test passed\n";
+
+    // A mistyped year costs an outlier day, not a century of dense bins, and an
+    // outlier arriving first does not keep the real days out of the dense range
+    auto dayOf = [](year_month_day date) { return sys_days(date).time_since_epoch().count(); };
+    std::int64_t typo = dayOf(year{2124} / 3 / 1), first = dayOf(year{2024} / 1 / 1);
+    for (bool typoFirst : {false, true}) {
+        TimeIndex index;
+        if (typoFirst) index.add(typo, Category::FOOD, Currency::GBP, money(5.0));
+        for (std::int64_t day = first; day < first + 400; ++day) {
+            index.add(day, Category::OTHER, Currency::GBP, money(1.0));
+        }
+        if (!typoFirst) index.add(typo, Category::FOOD, Currency::GBP, money(5.0));
+        assert(index.getCoveredDays() < 2 * 400 + 64 && index.getOutlierDays() == 1);
+        assert(index.getFirstDay() == first && index.getLastDay() == typo);
+        CategoryTotals all = index.totalsBetween(first, typo + 1);
+        assert(all.getCount(Category::OTHER, Currency::GBP) == 400 && all.getTotal(Category::FOOD, Currency::GBP) == money(5.0));
+        assert(index.totalsBetween(first + 10, first + 20).getCount(Category::OTHER, Currency::GBP) == 10);
+        assert(index.totalsBetween(first + 500, typo).getCount(Category::FOOD, Currency::GBP) == 0);
+        index.remove(typo, Category::FOOD, Currency::GBP, money(5.0));
+        assert(index.totalsBetween(typo, typo + 1).getCount(Category::FOOD, Currency::GBP) == 0);
+    }
+    std::cout << "  ✓ Outlier day test passed\n";
+}
+
+void testRateHistory() {
+    std::cout << "\nTesting RateHistory...\n";
+    
+    using namespace std::chrono;
+    auto dayOf = [](year_month_day date) { return sys_days(date).time_since_epoch().count(); };
+    std::int64_t jan = dayOf(year{2024} / 1 / 1), feb = dayOf(year{2024} / 2 / 1), mar = dayOf(year{2024} / 3 / 1);
+    
+    RateHistory history;
+    history.add(Currency::EUR, mar, 1.20);
+    history.add(Currency::EUR, jan, 1.10); // out of order
+    history.add(Currency::EUR, feb, 1.00);
+    history.add(Currency::EUR, feb, 1.15); // replaces
+    history.add(Currency::GBP, feb, 2.00); // the base is always 1
+    assert(history.size() == 3);
+    assert(history.getRate(Currency::EUR, jan - 1, 9.0) == 9.0);
+    assert(history.getRate(Currency::EUR, jan, 9.0) == 1.10);
+    assert(history.getRate(Currency::EUR, feb - 1, 9.0) == 1.10);
+    assert(history.getRate(Currency::EUR, feb + 10, 9.0) == 1.15);
+    assert(history.getRate(Currency::EUR, mar + 400, 9.0) == 1.20);
+    assert(history.getRate(Currency::JPY, mar, 9.0) == 9.0);
+    RateHistory::Cursor cursor;
+    for (std::int64_t day : {jan, feb + 10, mar + 1, jan + 3, jan - 5, mar + 400, feb}) {
+        assert(history.getRate(Currency::EUR, day, 9.0, cursor) == history.getRate(Currency::EUR, day, 9.0));
+    }
+    assert(history.getRate(Currency::EUR, jan + 3, 9.0, cursor) == 1.10); // jumps back past the cached interval
+    
+    CurrencyRates current;
+    assert(history.convert(money(11.0), Currency::EUR, Currency::GBP, jan, current) == money(10.0));
+    assert(history.convert(money(10.0), Currency::GBP, Currency::EUR, mar, current) == money(12.0));
+    std::cout << "  ✓ Dated lookup test passed\n";
+    
+    {
+        std::ofstream file("test_rates.csv");
+        file << "Date,Currency,Rate\n2024-01-01,usd,1.25\n2024-02-30,USD,1.5\n2024-03-01,XYZ,2\n"
+             << "2024-03-01,USD,abc\n2024-04-01,USD,1.3\n";
+    }
+    RateHistory loaded;
+    assert(loaded.load("test_rates.csv"));
+    assert(loaded.size() == 2);
+    assert(loaded.getRate(Currency::USD, dayOf(year{2024} / 3 / 31), 0.0) == 1.25);
+    assert(loaded.getRate(Currency::USD, dayOf(year{2024} / 4 / 1), 0.0) == 1.3);
+    assert(!loaded.load("no_such_rates.csv"));
+    std::cout << "  ✓ Rate file test passed\n";
+    
+    // Revaluing the ledger matches converting each entry at its local day's rates
+    std::mt19937 random(11);
+    RateHistory rates;
+    auto start = sys_days{year{2023} / 1 / 1};
+    for (int d = 0; d < 400; d += 1 + static_cast<int>(random() % 9)) {
+        for (auto currency : {Currency::USD, Currency::EUR, Currency::JPY}) {
+            double base = currency == Currency::JPY ? 180.0 : 1.2;
+            rates.add(currency, dayOf(year_month_day{start + days{d}}), base * (0.9 + (random() % 200) / 1000.0));
+        }
+    }
+    BudgetManager manager;
+    for (int i = 0; i < 3000; ++i) {
+        auto timestamp = system_clock::time_point(start + hours{random() % (24 * 420)} - days{10});
+        manager.restoreEntry(0, "Entry", Money::fromMinor(random() % 100000),
+                             static_cast<Category>(random() % CATEGORY_COUNT),
+                             static_cast<Currency>(random() % CURRENCY_COUNT), timestamp);
+    }
+    for (int id = 1; id <= 3000; id += 5) manager.deleteEntry(std::to_string(id));
+    
+    auto localDay = [](system_clock::time_point timestamp) {
+        std::time_t time = system_clock::to_time_t(timestamp);
+        std::tm local = *std::localtime(&time);
+        return sys_days(year_month_day{year{local.tm_year + 1900}, month{static_cast<unsigned>(local.tm_mon + 1)},
+                                       day{static_cast<unsigned>(local.tm_mday)}}).time_since_epoch().count();
+    };
+    for (auto reporting : {Currency::GBP, Currency::EUR}) {
+        std::array<Money, CATEGORY_COUNT> expected{};
+        RateHistory reference = rates; // a cold cache for every lookup order
+        for (const auto& entry : manager.getEntries()) {
+            expected[static_cast<std::size_t>(entry.getCategory())] +=
+                reference.convert(entry.getAmount(), entry.getCurrency(), reporting, localDay(entry.getTimestamp()),
+                                  manager.getRates());
+        }
+        assert(manager.getTotalsAtHistoricalRates(rates, reporting) == expected);
+    }
+    std::cout << "  ✓ Historical revaluation test passed\n";
+}
+
+void testSummarize() {
+    std::cout << "\nTesting Summarize...\n";
+    
+    // Three files with their own incomes, one of them a snapshot; descriptions
+    // with quoted newlines straddle the tiny read blocks used below
+    std::vector<std::string> files = {"test_summary_1.csv", "test_summary_2.csv", "test_summary_3.mofsnap"};
+    CategoryTotals expected;
+    Money expectedIncome;
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        BudgetManager manager;
+        manager.setBabuIncome(money(4000.0 + 100.0 * f));
+        manager.setRate(Currency::EUR, 1.25 + 0.25 * f);
+        for (int i = 0; i < 400; ++i) {
+            std::string description = i % 3 == 0 ? "Line\nbreak, \"" + std::to_string(i) + "\"" : "Plain";
+            manager.addEntry(description, money((i + 1) * 0.75 + f), static_cast<Category>((i + f) % CATEGORY_COUNT),
+                             static_cast<Currency>(i % CURRENCY_COUNT));
+        }
+        bool saved = f == 2 ? FileIO::saveSnapshot(manager, files[f]) : FileIO::saveBudget(manager, files[f]);
+        assert(saved);
+        
+        BudgetManager loaded;
+        assert(FileIO::loadAny(loaded, files[f]));
+        expected.merge(loaded.getCategoryTotals());
+        expectedIncome += loaded.getIncome();
+    }
+    
+    for (std::size_t blockBytes : {std::size_t{64}, std::size_t{1000}, CsvBlockReader::BLOCK_SIZE}) {
+        BudgetSummary summary;
+        assert(FileIO::summarize(files, summary, blockBytes));
+        assert(summary.files == 3 && summary.entries == 1200);
+        assert(summary.getIncome() == expectedIncome);
+        assert(summary.rates.getRate(Currency::EUR) == 1.75); // from the last file
+        for (auto category : CategoryManager::getAllCategories()) {
+            for (auto currency : CurrencyConverter::getAllCurrencies()) {
+                assert(summary.totals.getCount(category, currency) == expected.getCount(category, currency));
+                assert(summary.totals.getTotal(category, currency) == expected.getTotal(category, currency));
+            }
+        }
+    }
+    
+    // A negative income in a snapshot header is ignored by the summary just as by a load
+    {
+        std::fstream snapshot(files[2], std::ios::in | std::ios::out | std::ios::binary);
+        std::int64_t negative = -100;
+        snapshot.seekp(offsetof(SnapshotHeader, babuIncome));
+        snapshot.write(reinterpret_cast<const char*>(&negative), sizeof(negative));
+    }
+    BudgetManager loaded;
+    assert(FileIO::loadAny(loaded, files[2]) && loaded.getBabuIncome() == BudgetManager().getBabuIncome());
+    BudgetSummary single;
+    assert(FileIO::summarize(std::span(files).subspan(2), single) && single.getIncome() == loaded.getIncome());
+
+    BudgetSummary missing;
+    std::vector<std::string> none = {"no_such_budget.csv"};
+    assert(!FileIO::summarize(none, missing));
+    std::cout << "  ✓ Streaming summary test passed\n";
+}
+
+void testSnapshot() {
+    std::cout << "\nTesting Snapshot...\n";
+    
+    BudgetManager source;
+    source.setExchangeRate(1.3);
+    source.setRate(Currency::JPY, 181.25);
+    source.setMamuIncome(money(3100.0));
+    for (int i = 0; i < 500; ++i) {
+        source.addEntry(i % 5 == 0 ? "" : "Entry \"" + std::to_string(i) + "\"\n", money(i * 0.25),
+                        static_cast<Category>(i % CATEGORY_COUNT), static_cast<Currency>(i % CURRENCY_COUNT));
+    }
+    for (int i = 1; i <= 500; i += 3) source.deleteEntry(std::to_string(i));
+    source.deleteEntry("500"); // the highest ID must still not be reused
+    
+    std::string testFile = "test_budget.mofsnap";
+    assert(FileIO::saveSnapshot(source, testFile));
+    assert(SnapshotView::isSnapshot(testFile));
+    assert(!SnapshotView::isSnapshot("test_budget.csv"));
+    
+    SnapshotView view;
+    assert(view.open(testFile));
+    assert(view.size() == source.getEntryCount());
+    assert(view.getHeader().nextId == 501);
+    
+    BudgetManager restored;
+    assert(FileIO::loadAny(restored, testFile));
+    assert(restored.getEntryCount() == source.getEntryCount());
+    assert(restored.getExchangeRate() == 1.3 && restored.getMamuIncome() == money(3100.0));
+    assert(restored.getRate(Currency::JPY) == 181.25);
+    auto original = source.getEntries().begin();
+    for (const auto& entry : restored.getEntries()) {
+        const auto& expected = *original++;
+        assert(entry.getId() == expected.getId());
+        assert(entry.getDescription() == expected.getDescription());
+        assert(entry.getAmount() == expected.getAmount());
+        assert(entry.getCategory() == expected.getCategory());
+        assert(entry.getCurrency() == expected.getCurrency());
+        assert(entry.getTimestamp() == expected.getTimestamp());
+    }
+    assert(restored.addEntry("Next", money(1.0), Category::OTHER, Currency::GBP) == "501");
+    std::cout << "  ✓ Snapshot round trip test passed\n";
+    
+    // Flip one byte of the description heap; the checksum must catch it
+    {
+        std::fstream file(testFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(-3, std::ios::end);
+        char byte = 0;
+        file.read(&byte, 1);
+        file.seekp(-3, std::ios::end);
+        byte ^= 0x20;
+        file.write(&byte, 1);
+    }
+    assert(!view.open(testFile));
+    assert(view.open(testFile, false));
+    assert(!FileIO::loadSnapshot(restored, testFile));
+
+    // A category byte out of range, with the checksum recomputed to match, is still refused
+    for (std::size_t column : {0, 1}) {
+        std::string tamperedFile = "test_tampered.mofsnap";
+        assert(FileIO::saveSnapshot(source, tamperedFile));
+        std::string data;
+        {
+            std::ifstream in(tamperedFile, std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), {});
+        }
+        SnapshotHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        std::size_t rows = header.rowCount;
+        std::size_t categories = sizeof(SnapshotHeader) + SnapshotView::padded(header.currencyCount * sizeof(double)) +
+                                 SnapshotView::padded(rows * sizeof(EntryId)) + SnapshotView::padded(rows * sizeof(Money));
+        data[column == 0 ? categories + 7 : categories + SnapshotView::padded(rows) + 7] =
+            static_cast<char>(column == 0 ? 0xFF : CURRENCY_COUNT);
+        SnapshotChecksum checksum;
+        checksum.update(std::string_view(data).substr(sizeof(SnapshotHeader)));
+        header.checksum = checksum.value();
+        std::memcpy(data.data(), &header, sizeof(header));
+        {
+            std::ofstream out(tamperedFile, std::ios::binary | std::ios::trunc);
+            out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        }
+        SnapshotView tampered;
+        assert(!tampered.open(tamperedFile) && !tampered.open(tamperedFile, false));
+        BudgetManager target;
+        assert(!FileIO::loadSnapshot(target, tamperedFile) && target.getEntryCount() == 0);
+        std::filesystem::remove(tamperedFile);
+    }
+    std::cout << "  ✓ Snapshot checksum test passed\n";
+}
+
+// Asserts two managers hold the same entries in the same order and the same settings
+void assertSameBudget(const BudgetManager& actual, const BudgetManager& expected) {
+    assert(actual.getEntryCount() == expected.getEntryCount());
+    for (auto currency : CurrencyConverter::getAllCurrencies()) {
+        assert(actual.getRate(currency) == expected.getRate(currency));
+    }
+    assert(actual.getBabuIncome() == expected.getBabuIncome());
+    assert(actual.getMamuIncome() == expected.getMamuIncome());
+    assert(actual.getNextId() == expected.getNextId());
+    auto other = expected.getEntries().begin();
+    for (const auto& entry : actual.getEntries()) {
+        const auto& want = *other++;
+        assert(entry.getId() == want.getId());
+        assert(entry.getDescription() == want.getDescription());
+        assert(entry.getAmount() == want.getAmount());
+        assert(entry.getCategory() == want.getCategory());
+        assert(entry.getCurrency() == want.getCurrency());
+        assert(entry.getTimestamp() == want.getTimestamp());
+    }
+}
+
+void testJournal() {
+    std::cout << "\nTesting Journal...\n";
+    
+    std::string base = "test_journal.mofsnap";
+    std::filesystem::remove(base);
+    std::filesystem::remove(Journal::journalPath(base));
+    
+    BudgetManager expected;
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base, JournalOptions{.batchRecords = 4}));
+        for (int i = 0; i < 20; ++i) {
+            manager.addEntry("Entry " + std::to_string(i), money(i + 0.5), static_cast<Category>(i % CATEGORY_COUNT),
+                             Currency::GBP);
+        }
+        manager.modifyEntry("3", "Changed", money(99.0), Category::KITTENS, Currency::USD);
+        manager.deleteEntry("20");
+        manager.deleteEntry("7");
+        manager.setExchangeRate(1.21);
+        manager.setRate(Currency::CAD, 1.74);
+        manager.setBabuIncome(money(4800.0));
+        assert(journal.getPendingRecords() > 0);
+        journal.close();
+        assert(!std::filesystem::exists(base)); // nothing compacted yet
+        for (const auto& entry : manager.getEntries()) {
+            expected.restoreEntry(entry.getId(), entry.getDescription(), entry.getAmount(), entry.getCategory(),
+                                  entry.getCurrency(), entry.getTimestamp());
+        }
+        expected.setExchangeRate(1.21);
+        expected.setRate(Currency::CAD, 1.74);
+        expected.setBabuIncome(money(4800.0));
+        expected.reserveIdsBelow(manager.getNextId());
+    }
+    
+    BudgetManager replayed;
+    {
+        Journal journal;
+        assert(journal.open(replayed, base));
+        assert(journal.getReplayedRecords() == 26);
+        assertSameBudget(replayed, expected);
+        assert(replayed.addEntry("After replay", money(1.0), Category::OTHER, Currency::GBP) == "21");
+        replayed.deleteEntry("21");
+        expected.reserveIdsBelow(22);
+    }
+    std::cout << "  ✓ Journal replay test passed\n";
+    
+    // A torn final record is dropped and later appends follow the last good one
+    {
+        std::ofstream torn(Journal::journalPath(base), std::ios::app | std::ios::binary);
+        torn << "\x40\x00\x00\x00partial";
+    }
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base));
+        assert(journal.getReplayedRecords() == 28);
+        assertSameBudget(manager, expected);
+        manager.setMamuIncome(money(3000.0));
+    }
+    expected.setMamuIncome(money(3000.0));
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base));
+        assertSameBudget(manager, expected);
+    }
+    std::cout << "  ✓ Journal torn tail test passed\n";
+    
+    // Compaction folds the journal into the base; replaying a stale journal over
+    // the new base (a crash before the journal was truncated) changes nothing
+    std::filesystem::copy_file(Journal::journalPath(base), "test_journal.stale",
+                               std::filesystem::copy_options::overwrite_existing);
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base, JournalOptions{.compactBytes = 1}));
+        assert(journal.sync());
+        assert(std::filesystem::exists(base) && SnapshotView::isSnapshot(base));
+        assert(journal.getJournalBytes() < 64);
+    }
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base));
+        assert(journal.getReplayedRecords() == 0);
+        assertSameBudget(manager, expected);
+    }
+    std::filesystem::copy_file("test_journal.stale", Journal::journalPath(base),
+                               std::filesystem::copy_options::overwrite_existing);
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base));
+        assert(manager.getEntryCount() == expected.getEntryCount());
+        assert(manager.getTotalByCategory(Category::KITTENS, Currency::USD) == money(99.0));
+        assert(manager.getNextId() == expected.getNextId());
+    }
+    std::cout << "  ✓ Journal compaction test passed\n";
+
+    // A journal from another version, or too short to be one, is refused and left
+    // as it was rather than replaced by an empty one
+    for (std::string contents : {std::string("MOFJRNL\0\x01\0\0\0records", 19), std::string("MOFJ")}) {
+        {
+            std::ofstream old(Journal::journalPath(base), std::ios::binary | std::ios::trunc);
+            old << contents;
+        }
+        BudgetManager manager;
+        Journal journal;
+        assert(!journal.open(manager, base) && !journal.isOpen());
+        std::ifstream kept(Journal::journalPath(base), std::ios::binary);
+        assert(std::string(std::istreambuf_iterator<char>(kept), {}) == contents);
+    }
+    std::filesystem::remove(Journal::journalPath(base));
+    std::cout << "  ✓ Journal version check test passed\n";
+
+    // After an I/O error (here the compacted base cannot be written) the journal
+    // stops buffering records instead of holding every later change in memory
+    std::filesystem::create_directory(base + ".tmp");
+    {
+        BudgetManager manager;
+        Journal journal;
+        assert(journal.open(manager, base, JournalOptions{.batchRecords = 1, .compactBytes = 1}));
+        manager.addEntry("Lost", money(1.0), Category::OTHER, Currency::GBP);
+        assert(journal.hasFailed());
+        for (int i = 0; i < 100; ++i) manager.addEntry("Later", money(1.0), Category::OTHER, Currency::GBP);
+        assert(journal.getPendingRecords() == 0 && !journal.sync());
+    }
+    std::filesystem::remove(base + ".tmp");
+    std::filesystem::remove(Journal::journalPath(base));
+    std::cout << "  ✓ Journal failure test passed\n";
+}
+
+void testConcurrentBudgetManager() {
+    std::cout << "Testing ConcurrentBudgetManager...\n";
+
+    constexpr int WRITERS = 4;
+    constexpr int ADDS = 500;
+    ConcurrentBudgetManager ledger;
+    std::atomic<int> writersLeft = WRITERS;
+    std::atomic<bool> readerFailed = false;
+    std::atomic<long> snapshotsTaken = 0;
+
+    // Every entry is worth 1.00 and modifications only move it between categories,
+    // so any published copy must hold count * 1.00 in total
+    auto writer = [&](int w) {
+        for (int i = 0; i < ADDS; ++i) {
+            std::string id = ledger.addEntry("Entry " + std::to_string(w), money(1.0),
+                                             i % 2 ? Category::FOOD : Category::TRANSPORT, Currency::GBP);
+            if (i % 5 == 0) {
+                ledger.modifyEntry(id, "Moved", money(1.0), Category::KITTENS, Currency::GBP);
+            }
+        }
+        --writersLeft;
+    };
+    auto reader = [&] {
+        size_t lastCount = 0;
+        do {
+            auto snapshot = ledger.snapshot();
+            Money total;
+            for (const auto& entry : snapshot->getEntries()) total += entry.getAmount();
+            Money totals;
+            for (Category category : CategoryManager::getAllCategories()) {
+                totals += snapshot->getTotalByCategory(category, Currency::GBP);
+            }
+            size_t count = snapshot->getEntryCount();
+            if (count < lastCount || total != totals || total != Money::fromMinor(100 * static_cast<int64_t>(count))) {
+                readerFailed = true;
+            }
+            lastCount = count;
+            ++snapshotsTaken;
+        } while (writersLeft > 0);
+    };
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < WRITERS; ++w) threads.emplace_back(writer, w);
+    for (int r = 0; r < 2; ++r) threads.emplace_back(reader);
+    for (auto& thread : threads) thread.join();
+
+    assert(!readerFailed);
+    assert(snapshotsTaken > 0);
+    assert(ledger.getEntryCount() == WRITERS * ADDS);
+    assert(ledger.getTotalByCategory(Category::KITTENS, Currency::GBP) == money(WRITERS * ADDS / 5));
+    assert(ledger.getPublishCount() == 1 + WRITERS * (ADDS + ADDS / 5));
+    std::cout << "  ✓ No lost updates under concurrent writers and readers\n";
+
+    // A held snapshot keeps its view while newer copies are published
+    auto before = ledger.snapshot();
+    ledger.deleteEntry("1");
+    ledger.update([](BudgetManager& manager) {
+        for (int i = 0; i < 10; ++i) manager.addEntry("Batch", money(2.0), Category::OTHER, Currency::EUR);
+    });
+    assert(before->getEntryCount() == WRITERS * ADDS);
+    assert(ledger.getEntryCount() == WRITERS * ADDS + 9);
+    assert(ledger.getTotalByCategory(Category::OTHER, Currency::EUR) == money(20.0));
+    before.release();
+    std::cout << "  ✓ Snapshot isolation test passed\n";
+
+    // Readers are not held up by a writer sitting on the write lock
+    std::atomic<bool> writing = false;
+    std::thread slowWriter([&] {
+        ledger.update([&](BudgetManager& manager) {
+            writing = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            manager.addEntry("Slow", money(1.0), Category::OTHER, Currency::GBP);
+        });
+    });
+    while (!writing) std::this_thread::yield();
+    auto worst = std::chrono::steady_clock::duration::zero();
+    int reads = 0;
+    for (; reads < 1000; ++reads) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = ledger.getEntryCount();
+        worst = std::max(worst, std::chrono::steady_clock::now() - start);
+        assert(count == WRITERS * ADDS + 9);
+    }
+    slowWriter.join();
+    assert(worst < std::chrono::milliseconds(50));
+    assert(ledger.getEntryCount() == WRITERS * ADDS + 10);
+    std::cout << "  ✓ Reader stall test passed\n";
+
+    // A batch is one publish, one ledger copy
+    std::uint64_t publishes = ledger.getPublishCount();
+    std::vector<NewEntry> batch(50, NewEntry{"Bulk", money(1.0), Category::GROCERY, Currency::GBP});
+    assert(ledger.addEntries(batch) == WRITERS * ADDS + 12);
+    assert(ledger.getPublishCount() == publishes + 1 && ledger.getEntryCount() == WRITERS * ADDS + 60);
+    std::cout << "  ✓ Batched add test passed\n";
+
+    // Single-entry writes replay onto a freed copy rather than copying the ledger;
+    // a held snapshot or an oversized update falls back to a copy, and every
+    // published copy matches a plain manager given the same changes
+    BudgetManager reference;
+    ConcurrentBudgetManager replayed;
+    std::uint64_t copies = replayed.getFullCopyCount();
+    auto both = [&](auto&& mutation) {
+        mutation(reference);
+        replayed.update(mutation);
+    };
+    auto at = std::chrono::system_clock::time_point{} + std::chrono::hours{24 * 20000};
+    for (int i = 0; i < 3000; ++i) {
+        both([&](BudgetManager& manager) {
+            manager.restoreEntry(0, "Row " + std::to_string(i), money(1.0 + i % 7), static_cast<Category>(i % 5),
+                                 Currency::GBP, at + std::chrono::minutes{i});
+        });
+        if (i % 10 == 3) both([&](BudgetManager& manager) { manager.deleteEntry(std::to_string(i - 2)); });
+        if (i % 10 == 6) {
+            both([&](BudgetManager& manager) {
+                manager.modifyEntry(std::to_string(i), "Changed", money(2.5), Category::OTHER, Currency::EUR);
+            });
+        }
+    }
+    assert(replayed.getFullCopyCount() - copies <= 2);
+    auto held = replayed.snapshot();
+    both([](BudgetManager& manager) { manager.setRate(Currency::EUR, 1.2); });
+    both([](BudgetManager& manager) { manager.setBabuIncome(Money::fromMinor(123457)); });
+    both([](BudgetManager& manager) {
+        manager.deleteWhere([](const EntryView& entry) { return entry.getCategory() == Category::FOOD; });
+    });
+    both([](BudgetManager& manager) { manager.reserveIdsBelow(9000); });
+    assertSameBudget(*replayed.snapshot(), reference);
+    held.release();
+    std::vector<NewEntry> large(5000, NewEntry{"Large", money(1.0), Category::GROCERY, Currency::GBP, at});
+    copies = replayed.getFullCopyCount();
+    both([&](BudgetManager& manager) { manager.addEntries(large); });
+    assert(replayed.getFullCopyCount() == copies + 1);
+    both([&](BudgetManager& manager) { manager.restoreEntry(0, "After", money(4.0), Category::TRANSPORT, Currency::GBP, at); });
+    both([](BudgetManager& manager) { manager.clear(); });
+    both([&](BudgetManager& manager) { manager.restoreEntry(0, "Fresh", money(5.0), Category::OTHER, Currency::GBP, at); });
+    for (int i = 0; i < 3; ++i) {
+        auto snapshot = replayed.snapshot();
+        assertSameBudget(*snapshot, reference);
+        assert(snapshot->getTotalByCategory(Category::OTHER, Currency::GBP) == money(5.0));
+        both([](BudgetManager&) {});
+    }
+    std::cout << "  ✓ Replayed publish test passed\n";
+}
+
+void testIngestQueue() {
+    std::cout << "Testing IngestQueue...\n";
+
+    MpscQueue<int> ring(3); // rounded up to 4
+    assert(ring.capacity() == 4);
+    for (int i = 0; i < 4; ++i) {
+        int value = i;
+        assert(ring.tryPush(value));
+    }
+    int extra = 99;
+    assert(!ring.tryPush(extra) && extra == 99);
+    std::vector<int> popped;
+    assert(ring.popBatch(popped, 3) == 3);
+    assert(ring.tryPush(extra));
+    assert(ring.popBatch(popped, 10) == 2);
+    assert((popped == std::vector<int>{0, 1, 2, 3, 99}));
+    std::cout << "  ✓ Ring buffer test passed\n";
+
+    BudgetManager manager;
+    std::vector<NewEntry> batch = {{"Rent", money(900.0), Category::HOUSING, Currency::GBP},
+                                   {"Tea", money(3.0), Category::FOOD, Currency::GBP},
+                                   {"Hotel", money(120.0), Category::TOURISM, Currency::EUR}};
+    manager.addEntry("First", money(1.0), Category::OTHER, Currency::GBP);
+    assert(manager.addEntries(batch) == 2);
+    assert(manager.getEntryCount() == 4 && manager.getNextId() == 5);
+    const EntryStore& store = manager.getEntries();
+    assert(store[store.find(4)].getDescription() == "Hotel");
+    assert(manager.getTotalByCategory(Category::FOOD, Currency::GBP) == money(3.0));
+    assert(manager.getCategoryTotals().matches(manager.getEntries()));
+    std::cout << "  ✓ Batch add test passed\n";
+
+    // Producers outrun a small queue, so they get pushed back; nothing may be
+    // lost and each producer's entries must keep their order
+    constexpr int PRODUCERS = 4;
+    constexpr int ROWS = 2000;
+    ConcurrentBudgetManager ledger;
+    {
+        IngestQueue queue(ledger, IngestOptions{.capacity = 64, .maxBatch = 32});
+        std::vector<std::thread> producers;
+        for (int p = 0; p < PRODUCERS; ++p) {
+            producers.emplace_back([&, p] {
+                for (int i = 0; i < ROWS; ++i) {
+                    queue.push(NewEntry{std::to_string(p) + ":" + std::to_string(i), money(1.0),
+                                        static_cast<Category>(p), Currency::GBP});
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        queue.flush();
+        assert(ledger.getEntryCount() == PRODUCERS * ROWS);
+
+        IngestMetrics metrics = queue.getMetrics();
+        assert(metrics.enqueued == PRODUCERS * ROWS && metrics.committed == PRODUCERS * ROWS);
+        assert(metrics.depth == 0 && metrics.maxDepth <= 64);
+        assert(metrics.batches >= PRODUCERS * ROWS / 32 && metrics.maxCommit >= metrics.getMeanCommit());
+
+        NewEntry late{"Late", money(5.0), Category::OTHER, Currency::USD};
+        queue.push(late);
+    } // the destructor commits what is still queued
+    assert(ledger.getTotalByCategory(Category::OTHER, Currency::USD) == money(5.0));
+
+    auto snapshot = ledger.snapshot();
+    std::array<int, PRODUCERS> next{};
+    EntryId lastId = 0;
+    for (const auto& entry : snapshot->getEntries()) {
+        assert(entry.getId() > lastId);
+        lastId = entry.getId();
+        std::string description(entry.getDescription());
+        if (description == "Late") continue;
+        auto colon = description.find(':');
+        int producer = std::stoi(description.substr(0, colon));
+        assert(std::stoi(description.substr(colon + 1)) == next[producer]++);
+    }
+    for (Category category : {Category::FOOD, Category::GROCERY, Category::TRANSPORT, Category::HOUSING}) {
+        assert(snapshot->getTotalByCategory(category, Currency::GBP) == money(ROWS));
+    }
+    std::cout << "  ✓ Concurrent ingestion test passed\n";
 }
 
 int main() {
     std::cout << "=== Running Budget Tracker Tests ===\n\n";
     
     try {
+        testMoney();
         testCurrencyConverter();
         testCategoryManager();
+        testEntryStore();
+        testStringPool();
+        testHistogramKernel();
+        testCsvScanner();
         testBudgetManager();
+        testBulkMutations();
+        testQuery();
+    testSortedViews();
+    testEntryPager();
         testFileIO();
+        testTimeIndex();
+        testRateHistory();
+        testSnapshot();
+        testConcurrentBudgetManager();
+        testIngestQueue();
+        testSummarize();
+        testBatchRunner();
+        testJournal();
         
         std::cout << "\n=== All Tests Passed! ===\n";
         return 0;